@@ -1,58 +1,225 @@
+#include "gsc/compileCache.hpp"
 #include "gsc/error.hpp"
 #include "gsc/interpreter.hpp"
+#include "gsc/optimizer.hpp"
 #include "gsc/parser.hpp"
 #include "gsc/scanner.hpp"
+#include "gsc/serializer.hpp"
+#include "gsc/sourceFile.hpp"
+#include "gsc/sourceMap.hpp"
 #include "gsc/token.hpp"
+#include "gsc/typeInference.hpp"
+#include <charconv>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <optional>
+#include <system_error>
+#include <thread>
 #include <vector>
 
 void runFile(std::string_view filename);
+void compileFile(std::string_view filename, std::string_view output);
+void checkFile(std::string_view filename);
+void printCacheStatistics();
 void runPrompt();
 
 Interpreter interpreter{};
+OptimizationLevel optimizationLevel = OptimizationLevel::O1;
+bool timePasses = false;
+bool dumpTypes = false;
+bool compile = false;
+bool check = false;
+bool useCache = true;
+bool lazyBlocks = false;
+int maxDepth = Parser::DEFAULT_MAX_DEPTH;
+
+[[noreturn]] void usage(const char *program) {
+  std::cerr << "Usage: " << program
+            << " [-O0|-O1|-O2] [--time-passes] [--dump-types] [--no-cache]"
+            << " [--cache-stats] [--compile [-o file.scb]] [--check]"
+            << " [--lazy-blocks] [--max-depth N]"
+            << " [file.gsc | file.scb | -]"
+            << std::endl;
+  std::exit(EXIT_FAILURE);
+}
 
 int main(int argc, char *argv[]) {
-  if (argc > 2) {
-    std::cerr << "Usage: " << argv[0] << " [file.gsc]" << std::endl;
-    std::exit(EXIT_FAILURE);
-  } else if (argc == 2) {
-    runFile(argv[1]);
+  std::string_view filename;
+  std::string_view output;
+  bool cacheStats = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string_view argument = argv[i];
+    if (argument == "-O0") {
+      optimizationLevel = OptimizationLevel::O0;
+    } else if (argument == "-O1") {
+      optimizationLevel = OptimizationLevel::O1;
+    } else if (argument == "-O2") {
+      optimizationLevel = OptimizationLevel::O2;
+    } else if (argument == "--time-passes") {
+      timePasses = true;
+    } else if (argument == "--dump-types") {
+      dumpTypes = true;
+    } else if (argument == "--no-cache") {
+      useCache = false;
+    } else if (argument == "--cache-stats") {
+      cacheStats = true;
+    } else if (argument == "--compile") {
+      compile = true;
+    } else if (argument == "--check") {
+      check = true;
+    } else if (argument == "--lazy-blocks") {
+      lazyBlocks = true;
+    } else if (argument == "--max-depth" && i + 1 < argc) {
+      std::string_view value = argv[++i];
+      auto [end, error] =
+          std::from_chars(value.data(), value.data() + value.size(), maxDepth);
+      if (error != std::errc{} || end != value.data() + value.size() ||
+          maxDepth <= 0) {
+        usage(argv[0]);
+      }
+    } else if (argument == "-o" && i + 1 < argc && output.empty()) {
+      output = argv[++i];
+    } else if ((argument.starts_with("-") && argument != "-") ||
+               !filename.empty()) {
+      usage(argv[0]);
+    } else {
+      filename = argument;
+    }
+  }
+
+  if (cacheStats) {
+    if (compile || check || !filename.empty() || !output.empty()) {
+      usage(argv[0]);
+    }
+    printCacheStatistics();
+  } else if (check) {
+    if (compile || filename.empty() || !output.empty()) {
+      usage(argv[0]);
+    }
+    checkFile(filename);
+  } else if (compile) {
+    if (filename.empty() || (filename == "-" && output.empty())) {
+      usage(argv[0]);
+    }
+    compileFile(filename, output);
+  } else if (!output.empty()) {
+    usage(argv[0]);
+  } else if (!filename.empty()) {
+    runFile(filename);
   } else {
     runPrompt();
   }
 }
 
-std::string readFile(std::string_view filename) {
-  std::ifstream file(filename.data());
+std::vector<std::shared_ptr<Stmt>>
+parse(Scanner &scanner, std::size_t size, bool lazyBlocks) {
+  // The compile errors are collected (up to a limit) and written at the end
+  DiagnosticList diagnostics;
+  diagnosticSink = &diagnostics;
 
-  if (!file) {
-    std::cerr << "Could not open file: " << filename << std::endl;
-    std::exit(EXIT_FAILURE);
+  std::vector<std::shared_ptr<Stmt>> statements;
+  if (lazyBlocks || size >= 2 * Scanner::minChunkSize) {
+    // Large programs are scanned and parsed on several threads, and the
+    // deferred blocks keep their tokens
+    scanner.scanTokens();
+    Parser parser{scanner.getTokens()};
+    parser.setMaxDepth(maxDepth);
+    parser.setLazyBlocks(lazyBlocks);
+    statements = parser.parse(std::thread::hardware_concurrency());
   } else {
-    std::string content{std::istreambuf_iterator<char>(file),
-                        std::istreambuf_iterator<char>()};
-    return content;
+    // The tokens are scanned as the parser needs them
+    Parser parser{scanner};
+    parser.setMaxDepth(maxDepth);
+    statements = parser.parse();
+  }
+
+  diagnosticSink = nullptr;
+  diagnostics.print(std::cerr);
+  return statements;
+}
+
+std::vector<std::shared_ptr<Stmt>> parse(std::string_view program) {
+  Scanner scanner{program};
+  return parse(scanner, program.size(), false);
+}
+
+void execute(std::vector<std::shared_ptr<Stmt>> statements,
+             bool wholeProgram, std::string_view program = {}) {
+  if (dumpTypes) {
+    TypeInference inference;
+    inference.analyze(statements);
+    inference.dump(std::cerr);
   }
+
+  Optimizer optimizer{optimizationLevel, wholeProgram};
+  optimizer.setTimingOutput(timePasses ? &std::cerr : nullptr);
+  statements = optimizer.optimize(statements);
+
+  // The runtime errors give the column of the tokens in the program
+  std::optional<SourceMap> map;
+  if (!program.empty()) {
+    sourceMap = &map.emplace(program);
+  }
+  interpreter.interpret(statements);
+  sourceMap = nullptr;
 }
 
-void run(std::string_view program) {
+void run(std::string_view program, bool wholeProgram) {
+  // With --lazy-blocks, the blocks are parsed when they run, from the tokens
+  // of the scanner
   Scanner scanner{program};
-  scanner.scanTokens();
-  std::vector<Token> tokens = scanner.getTokens();
-  Parser parser{tokens};
-  std::vector<std::shared_ptr<Stmt>> statements = parser.parse();
+  std::vector<std::shared_ptr<Stmt>> statements =
+      parse(scanner, program.size(), lazyBlocks);
 
   if (hadError) {
     std::cerr << "Error while parsing the program." << std::endl;
   } else {
-    interpreter.interpret(statements);
+    execute(std::move(statements), wholeProgram, program);
   }
 }
 
 void runFile(std::string_view filename) {
-  std::string program = readFile(filename);
-  run(program);
+  try {
+    SourceFile source{std::string{filename}};
+    std::string_view content = source.getContent();
+    // The cache stores whole programs, so lazy blocks don't use it, and it
+    // can only load them as deep as the default depth
+    std::filesystem::path cacheDirectory;
+    if (useCache && !lazyBlocks && maxDepth == Parser::DEFAULT_MAX_DEPTH) {
+      cacheDirectory = CompileCache::defaultDirectory();
+    }
+    if (isSerialized(content)) {
+      // The AST is loaded as it was parsed, without scanning or parsing,
+      // and its tokens view the rebuilt source, which gives the columns
+      std::string restored;
+      std::vector<std::shared_ptr<Stmt>> statements =
+          deserializeRestoring(content, restored);
+      execute(std::move(statements), true, restored);
+    } else if (!cacheDirectory.empty()) {
+      CompileCache cache{cacheDirectory};
+      if (auto statements = cache.load(content)) {
+        execute(std::move(*statements), true, content);
+      } else {
+        std::vector<std::shared_ptr<Stmt>> parsed = parse(content);
+        if (hadError) {
+          std::cerr << "Error while parsing the program." << std::endl;
+        } else {
+          cache.store(content, parsed);
+          execute(std::move(parsed), true, content);
+        }
+      }
+    } else {
+      run(content, true);
+    }
+  } catch (const std::system_error &error) {
+    std::cerr << error.what() << std::endl;
+    std::exit(EXIT_FAILURE);
+  } catch (const FormatError &error) {
+    std::cerr << error.what() << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
 
   if (hadError) {
     std::cerr << "Error while running file: " << filename << std::endl;
@@ -64,6 +231,75 @@ void runFile(std::string_view filename) {
   }
 }
 
+void compileFile(std::string_view filename, std::string_view output) {
+  std::filesystem::path path = output.empty()
+                                   ? std::filesystem::path{filename}
+                                         .replace_extension(".scb")
+                                   : std::filesystem::path{output};
+  try {
+    SourceFile source{std::string{filename}};
+    std::vector<std::shared_ptr<Stmt>> statements = parse(source.getContent());
+    if (hadError) {
+      std::cerr << "Error while compiling file: " << filename << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+
+    std::string data = Serializer{}.serialize(statements, source.getContent());
+    std::ofstream file{path, std::ios::binary};
+    if (!file.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+      std::cerr << "Could not write file: " << path.string() << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+  } catch (const std::system_error &error) {
+    std::cerr << error.what() << std::endl;
+    std::exit(EXIT_FAILURE);
+  } catch (const FormatError &error) {
+    std::cerr << error.what() << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+}
+
+void checkFile(std::string_view filename) {
+  try {
+    // Every block is parsed, so all the syntax errors are reported
+    SourceFile source{std::string{filename}};
+    std::string_view content = source.getContent();
+    if (isSerialized(content)) {
+      deserialize(content);
+    } else {
+      parse(content);
+    }
+  } catch (const std::system_error &error) {
+    std::cerr << error.what() << std::endl;
+    std::exit(EXIT_FAILURE);
+  } catch (const FormatError &error) {
+    std::cerr << error.what() << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  if (hadError) {
+    std::cerr << "Error while checking file: " << filename << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+}
+
+void printCacheStatistics() {
+  std::filesystem::path directory = CompileCache::defaultDirectory();
+  if (directory.empty()) {
+    std::cerr << "There is no cache directory." << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  CompileCache::Statistics statistics =
+      CompileCache{directory}.getStatistics();
+  std::cout << "Directory: " << directory.string() << "\n"
+            << "Entries: " << statistics.entries << " (" << statistics.size
+            << " bytes)\n"
+            << "Hits: " << statistics.hits << "\n"
+            << "Misses: " << statistics.misses << "\n"
+            << "Evictions: " << statistics.evictions << std::endl;
+}
+
 void runPrompt() {
   while (true) {
     std::cout << ">> ";
@@ -72,7 +308,8 @@ void runPrompt() {
       std::cout << std::endl;
       break;
     } else {
-      run(line);
+      // Later lines can still read the global variables
+      run(line, false);
       hadError = false; // Reset error state for the next line
     }
   }
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "tokenType.hpp"
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+/** @enum CharClass
+ * @brief What a character can start (or continue) when scanning.
+ */
+enum class CharClass : std::uint8_t {
+  INVALID,    ///< Not part of the language (outside strings and comments)
+  WHITESPACE, ///< Space, tab, carriage return or new line
+  DIGIT,      ///< Starts a NUMBER and continues NUMBERs and IDENTIFIERs
+  ALPHA,      ///< Letters and underscore, which start IDENTIFIERs
+  QUOTE,      ///< Starts a STRING
+  SINGLE,     ///< A one-character token
+  OPERATOR,   ///< A token that can be followed by '=' (e.g. '<' or "<=")
+  SLASH,      ///< Division or the start of a comment
+};
+
+/** @struct CharInfo
+ * @brief The class of a character and the tokens it produces.
+ *
+ * @note `single` is the token of the character alone (for SINGLE, OPERATOR
+ * and SLASH) and `withEqual` the token if it's followed by '=' (only for
+ * OPERATOR), which are the transitions of the state machine that scans the
+ * operators.
+ */
+struct CharInfo {
+  CharClass type = CharClass::INVALID;
+  TokenType single = END_OF_FILE;
+  TokenType withEqual = END_OF_FILE;
+};
+
+/** @brief The CharInfo of every character, indexed as unsigned char. */
+inline constexpr std::array<CharInfo, 256> charTable = [] {
+  std::array<CharInfo, 256> table{};
+  for (unsigned char c : std::string_view{" \t\r\n"}) {
+    table[c].type = CharClass::WHITESPACE;
+  }
+  for (int c = '0'; c <= '9'; c++) {
+    table[c].type = CharClass::DIGIT;
+  }
+  for (int c = 'a'; c <= 'z'; c++) {
+    table[c].type = CharClass::ALPHA;
+    table[c - 'a' + 'A'].type = CharClass::ALPHA;
+  }
+  table['_'].type = CharClass::ALPHA;
+  table['"'].type = CharClass::QUOTE;
+
+  auto single = [&](unsigned char c, TokenType type) {
+    table[c] = {CharClass::SINGLE, type, END_OF_FILE};
+  };
+  single('(', LEFT_PAREN);
+  single(')', RIGHT_PAREN);
+  single('{', LEFT_BRACE);
+  single('}', RIGHT_BRACE);
+  single('-', MINUS);
+  single('+', PLUS);
+  single(';', SEMICOLON);
+  single('*', STAR);
+
+  auto withEqual = [&](unsigned char c, TokenType alone, TokenType equal) {
+    table[c] = {CharClass::OPERATOR, alone, equal};
+  };
+  withEqual('!', BANG, BANG_EQUAL);
+  withEqual('=', EQUAL, EQUAL_EQUAL);
+  withEqual('<', LESS, LESS_EQUAL);
+  withEqual('>', GREATER, GREATER_EQUAL);
+
+  table['/'] = {CharClass::SLASH, SLASH, END_OF_FILE};
+  return table;
+}();
+
+constexpr CharClass charClass(char c) {
+  return charTable[static_cast<unsigned char>(c)].type;
+}
+
+constexpr bool isDigit(char c) { return charClass(c) == CharClass::DIGIT; }
+
+constexpr bool isAlpha(char c) { return charClass(c) == CharClass::ALPHA; }
+
+constexpr bool isAlphaNumeric(char c) {
+  CharClass type = charClass(c);
+  return type == CharClass::ALPHA || type == CharClass::DIGIT;
+}
+
+constexpr bool isWhitespace(char c) {
+  return charClass(c) == CharClass::WHITESPACE;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "gsc/stmt.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+/** @class CompileCache
+ * @brief A directory of parsed programs, keyed by a hash of their source
+ * code, so running the same program again skips scanning and parsing it.
+ *
+ * @note The entries are serialized programs with their locations (see
+ * Serializer), and the hash also covers the version of the interpreter and
+ * of the format, so a new version never reads the entries of an old one.
+ * @note Each entry starts with the size and a second (independent) hash of
+ * its source, which are checked on load, so a collision of the keys is a
+ * miss instead of running another program.
+ * @note The counters of the statistics are updated under a lock, so
+ * concurrent runs don't lose updates.
+ * @note When the directory grows over its maximum size, the least recently
+ * used entries are removed (a hit updates the modification time of the
+ * entry, which is its last use).
+ * @note The cache never fails: if the directory can't be read or written,
+ * programs are just parsed again.
+ */
+class CompileCache {
+private:
+  std::filesystem::path directory;
+  std::uintmax_t maxSize;
+
+  /** @internal
+   * @brief Adds to the counters kept in the directory.
+   */
+  void count(std::uintmax_t hits, std::uintmax_t misses,
+             std::uintmax_t evictions);
+
+  /** @internal
+   * @brief Removes the least recently used entries until the directory fits
+   * in its maximum size, returning how many were removed.
+   */
+  std::uintmax_t evict();
+
+public:
+  /** @brief The default maximum size of the directory (64 MiB). */
+  static constexpr std::uintmax_t DEFAULT_MAX_SIZE = 64 << 20;
+
+  /** @struct Statistics
+   * @brief How the cache was used, since its directory was created.
+   */
+  struct Statistics {
+    std::uintmax_t hits = 0;
+    std::uintmax_t misses = 0;
+    std::uintmax_t evictions = 0;
+    std::uintmax_t entries = 0;
+    std::uintmax_t size = 0;
+  };
+
+  /** @brief Constructs a CompileCache.
+   *
+   * @param directory Where the entries are kept (it's created if needed).
+   * @param maxSize The maximum size of all the entries, in bytes.
+   */
+  CompileCache(std::filesystem::path directory,
+               std::uintmax_t maxSize = DEFAULT_MAX_SIZE);
+
+  /** @brief Returns the directory used by default: $GSC_CACHE_DIR, or the
+   * gsc directory in $XDG_CACHE_HOME or in ~/.cache (or an empty path if
+   * none of them is set).
+   */
+  static std::filesystem::path defaultDirectory();
+
+  /** @brief Returns the path of the entry of a program. */
+  std::filesystem::path entryPath(std::string_view source) const;
+
+  /** @brief Loads the parsed program of the given source code.
+   *
+   * @return The statements, or nothing if the program isn't cached (or its
+   * entry is corrupted, which removes it).
+   * @note The tokens of the statements are views into the source code, as
+   * if it was parsed, so they have the same lines and columns.
+   */
+  std::optional<std::vector<std::shared_ptr<Stmt>>>
+  load(std::string_view source);
+
+  /** @brief Adds the parsed program of the given source code.
+   *
+   * @param source The source code of the program.
+   * @param statements The statements returned by the Parser (without
+   * errors).
+   */
+  void store(std::string_view source,
+             const std::vector<std::shared_ptr<Stmt>> &statements);
+
+  Statistics getStatistics() const;
+};
@@ -5,6 +5,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 
 /** @class Environment
  * @brief Represents an environment for variable storage in the GSC interpreter.
@@ -15,7 +16,7 @@
 class Environment : public std::enable_shared_from_this<Environment> {
 private:
   std::shared_ptr<Environment> enclosing;
-  std::map<std::string, std::any> values;
+  std::map<std::string, std::any, std::less<>> values;
 
 public:
   /** @brief Constructs a new Environment.
@@ -41,8 +42,22 @@ public:
    *
    * @throws RuntimeError if the variable is not defined in this or any
    * enclosing environment.
+   * @note The returned reference is valid until the variable is assigned,
+   * taken or goes out of scope, so values can be read without copying them.
    */
-  std::any get(const Token &name) const;
+  const std::any &get(const Token &name) const;
+
+  /** @brief Moves the value of a variable out of the environment.
+   *
+   * @param name The Token representing the variable name.
+   * @return The value that was associated with the variable.
+   *
+   * @throws RuntimeError if the variable is not defined in this or any
+   * enclosing environment.
+   * @note The variable stays defined, but its value is replaced by nil. It
+   * must only be used when the value is never read again.
+   */
+  std::any take(const Token &name);
 
   /** @brief Assigns a value to a variable by its name.
    *
@@ -62,5 +77,5 @@ public:
    * @note This method does not check for existing variables with the same name,
    * allowing for redefinition within the same environment.
    */
-  void define(const std::string &name, std::any value);
+  void define(std::string_view name, std::any value);
 };
@@ -1,11 +1,80 @@
 #pragma once
 
 #include "gsc/runtimeError.hpp"
+#include "gsc/sourceMap.hpp"
+#include <cstddef>
+#include <iosfwd>
 #include <string>
+#include <vector>
 
 inline bool hadError = false;
 inline bool hadRuntimeError = false;
 
+/** @struct Diagnostic
+ * @brief A compile error, with the same fields that report() writes.
+ */
+struct Diagnostic {
+  int line;
+  std::string where;
+  std::string message;
+};
+
+/** @class DiagnosticList
+ * @brief Collects the compile errors of a program instead of writing them.
+ *
+ * @note Only the first `limit` errors are kept, and the rest are only
+ * counted, so a broken program (e.g. a generated file) can't produce
+ * megabytes of errors.
+ */
+class DiagnosticList {
+private:
+  std::vector<Diagnostic> diagnostics;
+  std::size_t limit;
+  std::size_t dropped = 0;
+
+public:
+  /** @brief The default number of errors kept. */
+  static constexpr std::size_t DEFAULT_LIMIT = 100;
+
+  DiagnosticList(std::size_t limit = DEFAULT_LIMIT);
+
+  /** @brief Adds an error, or counts it if the list is full. */
+  void add(int line, const std::string &where, const std::string &message);
+
+  /** @brief Adds an error at the given token, formatting its location like
+   * error() (unless the error is only counted).
+   */
+  void add(const Token &token, const std::string &message);
+
+  /** @brief Checks if the next errors will only be counted. */
+  bool isFull() const;
+
+  std::size_t getLimit() const;
+
+  /** @brief Adds the errors of another list after the ones of this list. */
+  void merge(const DiagnosticList &other);
+
+  const std::vector<Diagnostic> &getDiagnostics() const;
+
+  /** @brief Returns the number of errors that weren't kept. */
+  std::size_t getDropped() const;
+
+  /** @brief Writes the errors in the format of report(), followed by the
+   * number of errors that weren't kept (if any).
+   */
+  void print(std::ostream &out) const;
+};
+
+/** @brief Where report() adds the errors, or nullptr to write them in
+ * stderr.
+ */
+inline DiagnosticList *diagnosticSink = nullptr;
+
+/** @brief The SourceMap of the program being run, which gives the column of
+ * the runtime errors (or nullptr to only write their line).
+ */
+inline const SourceMap *sourceMap = nullptr;
+
 /** @brief
  * Report an error in the given line and location.
  *
@@ -14,7 +83,7 @@ inline bool hadRuntimeError = false;
  * @param message The error message to display.
  *
  * @note This function sets the global variable `hadError` to true and writes in
- * stderr.
+ * stderr (or adds the error to the `diagnosticSink`).
  */
 void report(const int &line, const std::string &where,
             const std::string &message);
@@ -44,6 +113,16 @@ void error(const int &line, const std::string &message);
  */
 void error(const Token &token, const std::string &message);
 
+/** @brief
+ * Report the errors collected in a list (e.g. on another thread), in order.
+ *
+ * @param diagnostics The errors to report.
+ *
+ * @note The errors are added to the `diagnosticSink` (or written in stderr)
+ * as if they were reported one by one.
+ */
+void report(const DiagnosticList &diagnostics);
+
 /** @brief
  * Report a runtime error given a RuntimeError object.
  *
@@ -51,5 +130,6 @@ void error(const Token &token, const std::string &message);
  *
  * @note This function sets the global variable `hadRuntimeError` to true and
  * writes in stderr.
+ * @note The column is only written if the token is in the `sourceMap`.
  */
 void runtimeError(const RuntimeError &error);
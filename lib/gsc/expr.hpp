@@ -12,6 +12,14 @@ class Assign;
 class Variable;
 class Logical;
 
+/** @enum OperandType
+ * @brief Statically proven type of both operands of a binary expression.
+ *
+ * @note It's filled by the TypeInference pass. UNKNOWN means that the
+ * interpreter must check the operand types at runtime.
+ */
+enum class OperandType { UNKNOWN, INT, STRING };
+
 /** @class ExprVisitor
  * @brief Abstract base class for expression visitors.
  *
@@ -55,6 +63,7 @@ private:
   const std::shared_ptr<Expr> left;
   const Token op;
   const std::shared_ptr<Expr> right;
+  OperandType operandType = OperandType::UNKNOWN;
 
 public:
   Binary(std::shared_ptr<Expr> left, Token op, std::shared_ptr<Expr> right)
@@ -66,7 +75,10 @@ public:
 
   std::shared_ptr<Expr> getLeft() const { return left; }
   std::shared_ptr<Expr> getRight() const { return right; }
-  Token getOp() const { return op; }
+  const Token &getOp() const { return op; }
+
+  OperandType getOperandType() const { return operandType; }
+  void setOperandType(OperandType type) { operandType = type; }
 };
 
 /** @class Grouping
@@ -109,7 +121,7 @@ public:
     return visitor.visitLiteralExpr(shared_from_this());
   }
 
-  std::any getValue() const { return value; }
+  const std::any &getValue() const { return value; }
 };
 
 /** @class Unary
@@ -146,6 +158,7 @@ class Assign : public Expr, public std::enable_shared_from_this<Assign> {
 private:
   const Token name;
   const std::shared_ptr<Expr> value;
+  bool deadStore = false;
 
 public:
   Assign(Token name, std::shared_ptr<Expr> value)
@@ -158,6 +171,10 @@ public:
   Token getName() const { return name; }
 
   std::shared_ptr<Expr> getValue() const { return value; }
+
+  /** @brief Checks if the assigned value is never read (set by Liveness). */
+  bool isDeadStore() const { return deadStore; }
+  void setDeadStore(bool dead) { deadStore = dead; }
 };
 
 /** @class Variable
@@ -170,6 +187,7 @@ public:
 class Variable : public Expr, public std::enable_shared_from_this<Variable> {
 private:
   const Token name;
+  bool lastUse = false;
 
 public:
   Variable(Token name) : name(std::move(name)) {}
@@ -179,6 +197,12 @@ public:
   }
 
   Token getName() const { return name; }
+
+  /** @brief Checks if the variable is never read again after this expression
+   * (set by Liveness), so its value can be moved out of the environment.
+   */
+  bool isLastUse() const { return lastUse; }
+  void setLastUse(bool last) { lastUse = last; }
 };
 
 /** @class Logical
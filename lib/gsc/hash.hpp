@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+/** @brief The initial value of a 64-bit FNV-1a hash. */
+inline constexpr std::uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325;
+
+/** @brief Hashes the bytes with 64-bit FNV-1a.
+ *
+ * @param bytes The bytes to hash.
+ * @param hash The hash of the previous bytes, to hash several strings as if
+ * they were concatenated.
+ */
+constexpr std::uint64_t hashBytes(std::string_view bytes,
+                                  std::uint64_t hash = FNV_OFFSET_BASIS) {
+  for (char c : bytes) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+static_assert(hashBytes("") == FNV_OFFSET_BASIS);
+static_assert(hashBytes("a") == 0xaf63dc4c8601ec8c);
+static_assert(hashBytes("b", hashBytes("a")) == hashBytes("ab"));
+
+/** @brief Hashes the bytes with another 64-bit function than hashBytes(),
+ * to check a match found by a hashBytes() key.
+ *
+ * @note Each byte is mixed with a multiplication by the golden ratio and a
+ * shift, so its collisions are independent of the ones of FNV-1a.
+ */
+constexpr std::uint64_t checksumBytes(std::string_view bytes) {
+  std::uint64_t hash = bytes.size();
+  for (char c : bytes) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 0x9e3779b97f4a7c15;
+    hash ^= hash >> 29;
+  }
+  return hash;
+}
+
+static_assert(checksumBytes("ab") != checksumBytes("ba"));
+static_assert(checksumBytes("") != checksumBytes(std::string_view{"", 1}));
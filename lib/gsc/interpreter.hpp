@@ -18,9 +18,38 @@ private:
   std::shared_ptr<Environment> environment{new Environment};
 
   std::any evaluate(std::shared_ptr<Expr> expr);
+
+  /** @internal
+   * @brief Evaluates an expression without copying the value of a literal or
+   * a variable (unless it's the last use of the variable).
+   *
+   * @param expr The expression to evaluate.
+   * @param temporary Where the value is stored when it has to be computed.
+   * @return A reference to the value, either to the literal, to the variable
+   * in the environment or to the temporary.
+   */
+  const std::any &evaluateInPlace(const std::shared_ptr<Expr> &expr,
+                                  std::any &temporary);
+
+  /** @internal
+   * @brief Checks if evaluating an expression surely keeps the value of the
+   * given variable in the environment.
+   */
+  bool preserves(const std::shared_ptr<Expr> &expr, const Token &name) const;
+
+  /** @internal
+   * @brief Evaluates an assignment and stores the value in its variable.
+   *
+   * @param expr The assignment.
+   * @param discarded If the result isn't used (an assignment statement), so
+   * the value is moved into the environment instead of copied.
+   * @return The assigned value (or nothing if it's discarded).
+   * @note A dead store writes nil instead of the value.
+   */
+  std::any assign(Assign &expr, bool discarded);
   void execute(std::shared_ptr<Stmt> stmt);
 
-  void executeBlock(const std::vector<std::shared_ptr<Stmt>> statements,
+  void executeBlock(const std::vector<std::shared_ptr<Stmt>> &statements,
                     std::shared_ptr<Environment> environment);
 
   std::any visitBinaryExpr(std::shared_ptr<Binary> expr) override;
@@ -38,7 +67,20 @@ private:
   std::any visitVarStmt(std::shared_ptr<Var> stmt) override;
 
   template <class... N>
-  void checkNumberOperands(const Token &op, N... operands);
+  void checkNumberOperands(const Token &op, const N &...operands);
+
+  /** @internal
+   * @brief Evaluates a binary operator whose operands are proven to be
+   * numbers, so no type checks are needed.
+   */
+  std::any evaluateIntBinary(const Token &op, int left, int right) const;
+
+  /** @internal
+   * @brief Evaluates a binary operator whose operands are proven to be
+   * strings, so no type checks are needed.
+   */
+  std::any evaluateStringBinary(const Token &op, const std::string &left,
+                                const std::string &right) const;
 
   bool isTruthy(const std::any &value) const;
   bool isEqual(const std::any &a, const std::any &b) const;
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "gsc/stmt.hpp"
+#include <memory>
+#include <vector>
+
+/** @class Liveness
+ * @brief Liveness analysis that lets the Interpreter release dead values.
+ *
+ * @note Every variable reference is first resolved to the declaration it
+ * refers to. Then the program is walked backwards, computing which variables
+ * can still be read at each point. Variable reads after which the variable
+ * is never read again are marked as last uses (so the Interpreter moves the
+ * value out of the environment instead of copying it), and declarations and
+ * assignments whose value is never read are marked as dead stores (so the
+ * value isn't kept in the environment).
+ * @note SC values can't escape the environment (there are no references or
+ * closures), so a variable that isn't live anymore can always be released.
+ * @note Deferred blocks (see Parser::setLazyBlocks()) aren't parsed: they
+ * are assumed to read every variable named in their tokens (and to write
+ * none), and their own variables are never released.
+ */
+class Liveness {
+private:
+  const bool wholeProgram;
+  int lastUses = 0;
+  int deadStores = 0;
+
+public:
+  /** @brief Constructs a Liveness analysis.
+   *
+   * @param wholeProgram If the analyzed statements are the whole program.
+   * It must be false when later statements can still read the global
+   * variables (e.g. in the REPL), so these are never released.
+   */
+  Liveness(bool wholeProgram = true);
+
+  /** @brief
+   * Analyze the given program and annotate its last uses and dead stores.
+   *
+   * @param statements The statements of the program.
+   */
+  void analyze(const std::vector<std::shared_ptr<Stmt>> &statements);
+
+  int getLastUses() const;
+  int getDeadStores() const;
+};
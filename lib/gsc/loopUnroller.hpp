@@ -0,0 +1,72 @@
+#pragma once
+
+#include "gsc/expr.hpp"
+#include "gsc/stmt.hpp"
+#include <memory>
+#include <vector>
+
+/** @class LoopUnroller
+ * @brief Unrolls counted loops with constant bounds.
+ *
+ * @note A counted loop is a `var i = A;` declaration immediately followed by
+ * a `while (i OP B) { ...; i = i +/- C; }` loop (this is what the Parser
+ * produces when desugaring a `for` statement), where A, B and C are number
+ * literals, OP is a comparison and the body doesn't assign or re-declare `i`.
+ * @note Loops that run at most `factor` times are fully unrolled. Longer loops
+ * get `factor` copies of the body per iteration, plus the remaining copies
+ * before the loop. Every unrolled loop consumes its code growth (in AST nodes)
+ * from the budget, and loops that don't fit in it are left untouched.
+ * @note Deferred blocks (see Parser::setLazyBlocks()) aren't parsed, so the
+ * loops inside them aren't unrolled. In a loop body, they count as one node
+ * per token, and as a write of `i` if they assign it.
+ */
+class LoopUnroller : public StmtVisitor {
+private:
+  const int factor;
+  int budget;
+  int unrolledLoops = 0;
+
+  std::shared_ptr<Stmt> transform(std::shared_ptr<Stmt> stmt);
+  std::vector<std::shared_ptr<Stmt>>
+  transform(const std::vector<std::shared_ptr<Stmt>> &statements);
+
+  /** @internal
+   * @brief Tries to unroll the given loop, whose induction variable was
+   * declared by the given statement.
+   *
+   * @return The statements that replace the loop, or an empty vector if it
+   * can't be unrolled.
+   */
+  std::vector<std::shared_ptr<Stmt>> unroll(const std::shared_ptr<Var> &init,
+                                            const std::shared_ptr<While> &loop);
+
+  std::any visitBlockStmt(std::shared_ptr<Block> stmt) override;
+  std::any visitExpressionStmt(std::shared_ptr<Expression> stmt) override;
+  std::any visitPrintStmt(std::shared_ptr<Print> stmt) override;
+  std::any visitIfStmt(std::shared_ptr<If> stmt) override;
+  std::any visitWhileStmt(std::shared_ptr<While> stmt) override;
+  std::any visitVarStmt(std::shared_ptr<Var> stmt) override;
+
+public:
+  /** @brief Constructs a LoopUnroller.
+   *
+   * @param factor The maximum number of body copies per unrolled loop.
+   * @param budget The maximum number of AST nodes that the whole
+   * transformation can add to the program.
+   */
+  LoopUnroller(int factor = 4, int budget = 256);
+
+  /** @brief
+   * Unroll the counted loops of the given program.
+   *
+   * @param statements The statements of the program.
+   * @return The transformed statements.
+   *
+   * @note The statements of the original program aren't modified, but the
+   * unrolled copies share the nodes of the original loop bodies.
+   */
+  std::vector<std::shared_ptr<Stmt>>
+  unroll(const std::vector<std::shared_ptr<Stmt>> &statements);
+
+  int getUnrolledLoops() const;
+};
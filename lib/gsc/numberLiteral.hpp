@@ -0,0 +1,66 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+
+/** @internal
+ * @brief Reads 8 digits at once (SWAR), returning their value.
+ *
+ * @note The bytes are combined in pairs, then in groups of 4 and finally all
+ * together, using 3 multiplications instead of 8.
+ */
+constexpr std::uint32_t parseEightDigits(const char *digits) {
+  std::uint64_t chunk = 0;
+  for (int i = 0; i < 8; i++) {
+    // The first digit goes to the lowest byte (a single load in little-endian)
+    chunk |= static_cast<std::uint64_t>(static_cast<unsigned char>(digits[i]))
+             << (8 * i);
+  }
+  chunk -= 0x3030303030303030;
+  chunk = chunk * 10 + (chunk >> 8);
+  chunk = (((chunk & 0x000000FF000000FF) * (100 + (1000000ULL << 32))) +
+           (((chunk >> 16) & 0x000000FF000000FF) * (1 + (10000ULL << 32)))) >>
+          32;
+  return static_cast<std::uint32_t>(chunk);
+}
+
+/** @brief Parses the digits of a NUMBER literal without allocating memory.
+ *
+ * @tparam T The integer type of the values of the language.
+ * @param digits The lexeme of the literal, which must only have digits.
+ *
+ * @return The value of the literal, or nothing if it doesn't fit in T.
+ * @note The digits are read 8 at a time, and only the tail one by one.
+ */
+template <std::integral T = int>
+constexpr std::optional<T> parseNumber(std::string_view digits) {
+  constexpr std::uint64_t limit = std::numeric_limits<T>::max();
+  std::uint64_t value = 0;
+  std::size_t i = 0;
+
+  for (; i + 8 <= digits.size(); i += 8) {
+    std::uint64_t chunk = parseEightDigits(digits.data() + i);
+    if (chunk > limit || value > (limit - chunk) / 100000000) {
+      return std::nullopt;
+    }
+    value = value * 100000000 + chunk;
+  }
+
+  for (; i < digits.size(); i++) {
+    std::uint64_t digit = static_cast<unsigned char>(digits[i]) - '0';
+    if (digit > limit || value > (limit - digit) / 10) {
+      return std::nullopt;
+    }
+    value = value * 10 + digit;
+  }
+  return static_cast<T>(value);
+}
+
+static_assert(parseNumber("12345678") == 12345678);
+static_assert(parseNumber("2147483647") == 2147483647);
+static_assert(!parseNumber("2147483648"));
+static_assert(parseNumber<std::int64_t>("9223372036854775807") ==
+              std::numeric_limits<std::int64_t>::max());
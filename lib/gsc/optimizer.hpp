@@ -0,0 +1,80 @@
+#pragma once
+
+#include "gsc/stmt.hpp"
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/** @enum OptimizationLevel
+ * @brief How much work the Optimizer does before running a program.
+ *
+ * @note O0 doesn't run any pass (useful for debugging), O1 runs the cheap
+ * passes that only annotate the tree and O2 runs all the passes, including
+ * the ones that transform and grow the tree.
+ */
+enum class OptimizationLevel { O0, O1, O2 };
+
+/** @class Pass
+ * @brief Abstract base class for the passes of the optimization pipeline.
+ */
+class Pass {
+public:
+  /** @brief Returns the name of the pass, as shown in the timing output. */
+  virtual std::string getName() const = 0;
+
+  /** @brief
+   * Run the pass over the given program.
+   *
+   * @param statements The statements of the program.
+   * @return The statements of the program after the pass.
+   */
+  virtual std::vector<std::shared_ptr<Stmt>>
+  run(const std::vector<std::shared_ptr<Stmt>> &statements) = 0;
+
+  virtual ~Pass() = default;
+};
+
+/** @class Optimizer
+ * @brief Pipeline of passes that is run between the Parser and the
+ * Interpreter.
+ *
+ * @note The passes are run in the order they were added. The constructor
+ * adds the default passes of the given optimization level.
+ */
+class Optimizer {
+private:
+  std::vector<std::unique_ptr<Pass>> passes;
+  std::ostream *timingOutput = nullptr;
+
+public:
+  /** @brief Constructs an Optimizer with the default passes of a level.
+   *
+   * @param level The optimization level.
+   * @param wholeProgram If the optimized statements are the whole program.
+   * It must be false when later statements can still use the global
+   * variables (e.g. in the REPL).
+   */
+  Optimizer(OptimizationLevel level = OptimizationLevel::O1,
+            bool wholeProgram = true);
+
+  /** @brief Appends a pass at the end of the pipeline. */
+  void addPass(std::unique_ptr<Pass> pass);
+
+  /** @brief Sets where the time spent in each pass is written.
+   *
+   * @param out The stream for the timings, or nullptr to disable them.
+   */
+  void setTimingOutput(std::ostream *out);
+
+  std::vector<std::string> getPassNames() const;
+
+  /** @brief
+   * Run all the passes of the pipeline over the given program.
+   *
+   * @param statements The statements of the program.
+   * @return The optimized statements.
+   */
+  std::vector<std::shared_ptr<Stmt>>
+  optimize(const std::vector<std::shared_ptr<Stmt>> &statements);
+};
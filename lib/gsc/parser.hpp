@@ -1,12 +1,42 @@
 #pragma once
 
 #include "gsc/expr.hpp"
+#include "gsc/scanner.hpp"
 #include "gsc/stmt.hpp"
 #include "gsc/token.hpp"
+#include <cstdint>
+#include <deque>
 #include <memory>
-#include <stdexcept>
+#include <optional>
+#include <span>
 #include <vector>
 
+class DiagnosticList;
+
+/** @struct StatementSpan
+ * @brief The tokens a top-level statement was parsed from.
+ *
+ * @note The hash covers the type, the text and the line of each token, so
+ * equal hashes mean that the statement would be parsed into the same AST.
+ */
+struct StatementSpan {
+  std::size_t begin;
+  std::size_t end;
+  std::uint64_t hash;
+};
+
+/** @struct ParsedProgram
+ * @brief The top-level statements of a program and their spans, which let
+ * the Parser reuse them after an edit.
+ */
+struct ParsedProgram {
+  std::vector<std::shared_ptr<Stmt>> statements;
+  std::vector<StatementSpan> spans;
+
+  /** @brief The index of the END_OF_FILE token. */
+  std::size_t end = 0;
+};
+
 /** @class Parser
  * @brief Parser module for the GSC programming language.
  *
@@ -16,22 +46,123 @@
 class Parser {
 private:
   /** @internal
-   * @class ParseError
-   * @brief Exception class for parser errors.
+   * @brief Whether the Parser is recovering from an error.
    *
-   * @note This exception is thrown when the parser encounters an error during
-   * parsing.
-   * @note It inherits from std::runtime_error to provide a standard error
-   * interface.
+   * @note Errors aren't thrown: the parsing functions return nullptr while
+   * panicking, up to the declaration() that synchronizes, so an error costs
+   * as much as a return (and error-heavy programs parse as fast as valid
+   * ones).
    */
-  struct ParseError : public std::runtime_error {
-    using std::runtime_error::runtime_error;
-  };
+  bool panicking = false;
 
-  const std::vector<Token> &tokens;
+  /** @internal
+   * @brief Whether the parsing stopped (the program is nested too deeply),
+   * instead of synchronizing, since the rest of the program would be as deep
+   * and report the same error again.
+   */
+  bool aborted = false;
+
+  std::span<const Token> tokens;
   int current = 0;
 
+  /** @internal
+   * @brief The Scanner the tokens are pulled from, if the Parser was built
+   * with one. Then `window` only holds the previous and the current tokens.
+   */
+  Scanner *scanner = nullptr;
+  std::deque<Token> window;
+
+  /** @internal
+   * @brief The END_OF_FILE token after the tokens of a chunk (parsed on
+   * another thread), which don't end with one.
+   */
+  std::optional<Token> endOfChunk;
+
+  /** @internal
+   * @brief Where the errors are collected instead of reported, when parsing
+   * a chunk on another thread.
+   */
+  DiagnosticList *diagnostics = nullptr;
+
+  /** @internal
+   * @brief The current nesting of statements and expressions, which bounds
+   * the height of the AST (and the recursion of the passes that visit it).
+   */
+  int depth = 0;
+  int maxDepth = DEFAULT_MAX_DEPTH;
+
+  /** @internal
+   * @brief Whether the bodies of the blocks are deferred (see
+   * setLazyBlocks()).
+   */
+  bool lazyBlocks = false;
+
+  /** @internal
+   * @struct DepthScope
+   * @brief Restores the nesting depth when a parsing function returns.
+   */
+  struct DepthScope {
+    Parser &parser;
+    const int saved;
+
+    DepthScope(Parser &parser) : parser(parser), saved(parser.depth) {}
+    ~DepthScope() { parser.depth = saved; }
+  };
+
+  /** @internal
+   * @brief Enters a nesting level, reporting an error at the given token if
+   * it's deeper than the maximum depth.
+   *
+   * @return false (and stops the parsing) if the nesting is too deep.
+   */
+  bool nest(const Token &token, std::string_view message);
+
+  /** @internal
+   * @brief Splits the remaining tokens in up to the given number of chunks,
+   * returning the index of the first token of each one.
+   *
+   * @note A pre-pass balances the parentheses and braces, so the chunks only
+   * start after a top-level statement (a ';' or '}' that isn't followed by
+   * an `else`).
+   */
+  std::vector<std::size_t> findSplits(std::size_t chunks) const;
+
+  /** @internal
+   * @brief Parses the next top-level statement, adding it and its span.
+   */
+  void parseStatement(ParsedProgram &program);
+
+  /** @internal
+   * @brief Checks if a statement of the previous program is reused at the
+   * given token, adding it (and skipping its tokens) if so.
+   *
+   * @note The statement is reused if it was parsed without errors, the
+   * tokens at that position have its hash and the next token isn't an
+   * `else` (the only token after a statement that changes how it's parsed).
+   */
+  bool reuse(ParsedProgram &program, const ParsedProgram &previous,
+             std::size_t index, std::size_t position);
+
+  std::uint64_t hashTokens(std::size_t begin, std::size_t end) const;
+
   std::vector<std::shared_ptr<Stmt>> block();
+
+  /** @internal
+   * @brief Skips the tokens of a block up to its matching '}', returning a
+   * deferred Block with them (or nullptr if the braces aren't balanced, so
+   * the block is parsed now and the error is reported).
+   */
+  std::shared_ptr<Stmt> deferredBlock();
+
+  /** @internal
+   * @brief Parses the tokens of a deferred block, at the nesting depth of
+   * the block.
+   *
+   * @throws RuntimeError if there are syntax errors (after reporting them).
+   */
+  static std::vector<std::shared_ptr<Stmt>>
+  parseDeferred(std::span<const Token> tokens, int depth, int maxDepth);
+
   std::shared_ptr<Stmt> declaration();
   std::shared_ptr<Stmt> statement();
   std::shared_ptr<Stmt> printStatement();
@@ -41,33 +172,46 @@ private:
   std::shared_ptr<Stmt> varDeclaration();
   std::shared_ptr<Stmt> expressionStatement();
   std::shared_ptr<Expr> assignment();
-  std::shared_ptr<Expr> orLogical();
-  std::shared_ptr<Expr> andLogical();
   std::shared_ptr<Expr> expression();
-  std::shared_ptr<Expr> equality();
-  std::shared_ptr<Expr> comparison();
-  std::shared_ptr<Expr> term();
-  std::shared_ptr<Expr> factor();
-  std::shared_ptr<Expr> unary();
-  std::shared_ptr<Expr> primary();
+
+  /** @internal
+   * @brief Parses the binary and logical operators with a Pratt parser.
+   *
+   * @param precedence The minimum precedence of the operators to parse (the
+   * ones with lower precedence are left to the caller).
+   * @note The precedence of each operator is in a table indexed by its
+   * TokenType, so each operand is parsed in a single call to prefix().
+   */
+  std::shared_ptr<Expr> binary(int precedence);
+
+  /** @internal
+   * @brief Parses an operand: a unary expression or a primary one.
+   */
+  std::shared_ptr<Expr> prefix();
 
   template <class... T> bool match(T... types);
   bool check(TokenType type) const;
   bool isAtEnd() const;
 
-  Token consume(TokenType type, std::string_view message);
-  Token advance();
-  Token peek() const;
-  Token previous() const;
+  /** @internal
+   * @note The cursor returns references, so matching a token doesn't copy
+   * it. The references are valid until the next call to advance() (when
+   * pulling from a Scanner) or as long as the tokens (otherwise).
+   * @note consume() returns nullptr (and reports an error) if the next token
+   * isn't of the given type.
+   */
+  const Token *consume(TokenType type, std::string_view message);
+  const Token &advance();
+  const Token &peek() const;
+  const Token &previous() const;
 
   /** @internal
-   * @brief Throws a ParseError with the given token and message.
+   * @brief Reports an error at the given token and starts panicking.
    *
    * @param token The token where the error occurred.
    * @param message The error message to display.
-   * @return ParseError The thrown ParseError exception.
    */
-  ParseError error(const Token &token, std::string_view message);
+  void error(const Token &token, std::string_view message);
 
   /** @internal
    * @brief Synchronizes the parser state after an error.
@@ -78,11 +222,35 @@ private:
   void synchronize();
 
 public:
+  /** @brief The default maximum nesting of statements and expressions. */
+  static constexpr int DEFAULT_MAX_DEPTH = 1000;
+
+  /** @brief How many binary operators of a chain count as a nesting level.
+   *
+   * @note The chain is parsed in a loop, so it doesn't nest the Parser, but
+   * its AST is as deep as the chain is long and the passes visit it
+   * recursively, so it's only bounded more loosely.
+   */
+  static constexpr int OPERATORS_PER_LEVEL = 8;
+
   /** @brief Constructs a Parser object.
    *
-   * @param tokens The vector of tokens to parse.
+   * @param tokens The tokens to parse (they aren't copied, so they must
+   * outlive the Parser).
+   */
+  Parser(std::span<const Token> tokens);
+
+  /** @brief Constructs a Parser that pulls the tokens from a Scanner.
+   *
+   * @param scanner The Scanner of the source code (it must outlive the
+   * Parser).
+   *
+   * @note The tokens are scanned as the Parser needs them, so the memory used
+   * for them doesn't depend on the size of the source code.
+   * @note The syntax errors are reported after the errors of the Scanner,
+   * like with the scanned tokens.
    */
-  Parser(const std::vector<Token> &tokens);
+  Parser(Scanner &scanner);
 
   /** @brief Parses the tokens and returns a vector of statements.
    *
@@ -93,4 +261,71 @@ public:
    * the parsed statements.
    */
   std::vector<std::shared_ptr<Stmt>> parse();
+
+  /** @brief Parses the tokens, keeping the span of each top-level statement.
+   *
+   * @note The Parser must be built from the tokens (not a Scanner).
+   */
+  ParsedProgram parseProgram();
+
+  /** @brief Parses the tokens of an edited program, reusing the statements
+   * of its previous version that didn't change.
+   *
+   * @param previous The result of parsing the previous version.
+   *
+   * @note The statements before and after the edit are matched by their
+   * spans and hashes (from the start and the end of the program), so only
+   * the statements between them are parsed. The unchanged statements are
+   * the same objects as in `previous`.
+   * @note A statement only matches if its tokens are on the same lines, so
+   * an edit that adds or removes lines reparses the statements below it.
+   * @note The reused statements still point into the previous source code,
+   * which must outlive them.
+   * @note The Parser must be built from the tokens (not a Scanner).
+   */
+  ParsedProgram reparse(const ParsedProgram &previous);
+
+  /** @brief Minimum number of tokens parsed by a thread. */
+  static constexpr std::size_t minChunkSize = 1 << 16;
+
+  /** @brief Parses the tokens on up to the given number of threads.
+   *
+   * @param threads The maximum number of threads (including the caller).
+   * @param chunkSize The minimum number of tokens parsed by a thread.
+   *
+   * @note Each thread parses a chunk of top-level statements into its own
+   * list, and the lists are concatenated in order. The errors of each chunk
+   * are reported after the ones of the previous chunks, so they are in
+   * source order.
+   * @note The statements are the same as if the program was parsed on a
+   * single thread. If there are errors, the recovery doesn't skip tokens
+   * past the end of a chunk.
+   * @note A Parser that pulls the tokens from a Scanner parses on a single
+   * thread.
+   */
+  std::vector<std::shared_ptr<Stmt>>
+  parse(unsigned threads, std::size_t chunkSize = minChunkSize);
+
+  /** @brief Sets the maximum nesting of statements and expressions.
+   *
+   * @note Deeper programs (e.g. with thousands of nested parentheses, or
+   * long chains of operators) are reported as errors instead of parsed, so
+   * neither the Parser nor the passes that visit the AST overflow the stack.
+   * A chain of binary operators counts as one level every
+   * OPERATORS_PER_LEVEL operators.
+   */
+  void setMaxDepth(int limit);
+
+  /** @brief Sets whether the bodies of the blocks are parsed lazily.
+   *
+   * @note A pre-pass balances the braces of each block, and the Block only
+   * keeps its tokens, which are parsed the first time it runs (see
+   * Block::getStatements()). The blocks that never run (e.g. the branches
+   * of a debug mode) are never parsed, but their syntax errors are only
+   * reported if they run.
+   * @note The tokens must outlive the statements, and the Parser must be
+   * built from them (a Parser that pulls the tokens from a Scanner parses
+   * every block).
+   */
+  void setLazyBlocks(bool lazy);
 };
@@ -1,17 +1,76 @@
 #pragma once
 
+#include "simdScan.hpp"
 #include "token.hpp"
-#include <map>
+#include <algorithm>
+#include <array>
+#include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
-static const std::map<std::string_view, TokenType> keywords = {
-    {"and", TokenType::AND},   {"or", TokenType::OR},
-    {"if", TokenType::IF},     {"else", TokenType::ELSE},
-    {"true", TokenType::TRUE}, {"false", TokenType::FALSE},
-    {"for", TokenType::FOR},   {"while", TokenType::WHILE},
-    {"nil", TokenType::NIL},   {"print", TokenType::PRINT},
-    {"var", TokenType::VAR}};
+/** @struct Keyword
+ * @brief A reserved word of the language and the type of its token.
+ */
+struct Keyword {
+  std::string_view text;
+  TokenType type = IDENTIFIER;
+};
+
+inline constexpr std::array<Keyword, 11> keywords = {{
+    {"and", AND},   {"or", OR},       {"if", IF},       {"else", ELSE},
+    {"true", TRUE}, {"false", FALSE}, {"for", FOR},     {"while", WHILE},
+    {"nil", NIL},   {"print", PRINT}, {"var", VAR},
+}};
+
+/** @brief Hash of a (non-empty) word that is perfect for the keywords.
+ *
+ * @note It only looks at the length and the first and last characters, so
+ * it doesn't need to read the whole word.
+ */
+constexpr std::size_t keywordHash(std::string_view text) {
+  return (text.size() + static_cast<unsigned char>(text.front()) +
+          5 * static_cast<unsigned char>(text.back())) %
+         32;
+}
+
+/** @brief The keywords indexed by their hash. The empty slots hold an empty
+ * text, which never matches an identifier. */
+inline constexpr std::array<Keyword, 32> keywordTable = [] {
+  std::array<Keyword, 32> table{};
+  for (const Keyword &keyword : keywords) {
+    table[keywordHash(keyword.text)] = keyword;
+  }
+  return table;
+}();
+
+static_assert(std::ranges::all_of(keywords,
+                                  [](const Keyword &keyword) {
+                                    const std::size_t hash =
+                                        keywordHash(keyword.text);
+                                    return keywordTable[hash].text ==
+                                           keyword.text;
+                                  }),
+              "keywordHash must not have collisions between keywords");
+
+/** @brief Returns the token type of a word: its keyword or IDENTIFIER.
+ *
+ * @param text The word, which must not be empty.
+ */
+constexpr TokenType keywordType(std::string_view text) {
+  const Keyword &candidate = keywordTable[keywordHash(text)];
+  return candidate.text == text ? candidate.type : IDENTIFIER;
+}
+
+/** @struct SourceEdit
+ * @brief A change of the source code: `removed` characters at `offset` were
+ * replaced with `inserted` new ones.
+ */
+struct SourceEdit {
+  std::size_t offset;
+  std::size_t removed;
+  std::size_t inserted;
+};
 
 /** @class Scanner
  * @brief Lexical analyzer for the GSC programming language.
@@ -27,25 +86,39 @@ private:
   int start = 0;
   int current = 0;
   int line = 1;
+  const ScanFunctions &simd;
 
   /** @internal
-   *
-   * @brief Adds a token without literal value to the token list.
-   *
-   * @param type The type of the token to add.
-   * @see addToken(TokenType type, std::any literal)
+   * @brief Errors kept until they can be reported in order (when scanning a
+   * chunk of the program on another thread).
    */
-  void addToken(TokenType type);
+  bool deferErrors = false;
+  std::vector<std::pair<int, std::string>> deferredErrors;
+
+  /** @internal
+   * @struct Split
+   * @brief The start of a chunk of the program and the line it starts at.
+   */
+  struct Split {
+    std::size_t offset;
+    int line;
+  };
+
+  /** @internal
+   * @brief Constructs the Scanner of a chunk of a program, starting at the
+   * given line and deferring its errors.
+   */
+  Scanner(std::string_view chunk, const ScanFunctions &simd, int line);
 
   /** @internal
    *
-   * @brief Adds a token with a literal value to the token list.
+   * @brief Adds a token to the token list.
    *
    * @param type The type of the token to add.
-   * @param literal The literal value of the token (can be null).
-   * @see addToken(TokenType type)
+   * @note The lexeme isn't copied, and the literal value of NUMBER and STRING
+   * tokens is only decoded when the Parser asks for it.
    */
-  void addToken(TokenType type, std::any literal);
+  void addToken(TokenType type);
 
   /** @internal
    *
@@ -57,6 +130,28 @@ private:
    **/
   void scanToken();
 
+  /** @internal
+   * @brief Scans the rest of the source code, without adding END_OF_FILE.
+   */
+  void scanRemaining();
+
+  /** @internal
+   *
+   * @brief Finds where to split the rest of the source code into the given
+   * number of chunks of similar size.
+   *
+   * @note A chunk always starts after a new line that isn't inside a string,
+   * so each one can be scanned on its own. The pre-pass only looks for
+   * strings and comments, which is much cheaper than scanning the tokens.
+   */
+  std::vector<Split> findSplits(std::size_t chunks) const;
+
+  /** @internal
+   * @brief Reports a scanning error in the current line.
+   * @see error(int line, const std::string &message)
+   */
+  void reportError(const std::string &message);
+
   void identifier();
   void number();
   void string();
@@ -68,17 +163,71 @@ private:
   bool isAtEnd() const;
   char advance();
 
+  /** @internal
+   * @brief Moves `current` to the end of a run found by the ScanFunctions.
+   */
+  void advanceTo(const char *position);
+  const char *currentPosition() const;
+  const char *endPosition() const;
+
 public:
   /** @brief Constructs a Scanner object.
    *
    * @param program The source code to be scanned.
+   * @param level The instructions used to skip runs of characters (by default
+   * the best ones supported by the CPU).
    *
    * @note The program is stored as a string_view to avoid unnecessary copies.
    */
-  Scanner(std::string_view program);
+  Scanner(std::string_view program, SimdLevel level = detectSimdLevel());
+
+  /** @brief Minimum size of the chunks scanned on different threads. */
+  static constexpr std::size_t minChunkSize = 1 << 20;
 
-  /** @brief Scans the entire source code and generates a list of tokens. */
+  /** @brief Scans the entire source code and generates a list of tokens.
+   *
+   * @note Large programs are scanned in parallel on all the hardware threads.
+   * @see scanTokens(unsigned threads, std::size_t chunkSize)
+   */
   void scanTokens();
 
-  std::vector<Token> getTokens() const;
+  /** @brief Scans the entire source code on up to the given number of
+   * threads.
+   *
+   * @param threads The maximum number of threads (including the caller).
+   * @param chunkSize The minimum number of characters scanned by a thread.
+   *
+   * @note The tokens, their lines and the reported errors (in source order)
+   * are the same as if the program was scanned on a single thread.
+   */
+  void scanTokens(unsigned threads, std::size_t chunkSize = minChunkSize);
+
+  /** @brief Scans and returns the next token of the source code.
+   *
+   * @return The next token, or an END_OF_FILE token once the whole source
+   * code was scanned (also in the following calls).
+   * @note Only the current token is kept in memory, so it's meant to be used
+   * instead of scanTokens() and getTokens(), not together with them.
+   */
+  Token next();
+
+  /** @brief Scans an edited program reusing the tokens of the previous
+   * version, and only scanning again the characters around the edit.
+   *
+   * @param previous The tokens of the previous version of the program.
+   * @param previousProgram The previous version, which `previous` points to.
+   * @param edit The change that turned `previousProgram` into this program.
+   *
+   * @return The number of tokens that had to be scanned again.
+   * @note Scanning restarts after the last token that ends before the edit
+   * and stops as soon as a token starts where a previous token (after the
+   * edit) started. From there on, the rest of the tokens are the same, so
+   * they are relocated to the new program instead of scanned again.
+   * @note Only the errors of the scanned part are reported.
+   */
+  std::size_t rescan(const std::vector<Token> &previous,
+                     std::string_view previousProgram, const SourceEdit &edit);
+
+  /** @brief Returns the scanned tokens, without copying them. */
+  const std::vector<Token> &getTokens() const;
 };
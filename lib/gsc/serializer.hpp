@@ -0,0 +1,155 @@
+#pragma once
+
+#include "gsc/expr.hpp"
+#include "gsc/sourceMap.hpp"
+#include "gsc/stmt.hpp"
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/** @brief The first bytes of a serialized program (a .scb file). */
+inline constexpr std::string_view SERIALIZED_MAGIC = "GSCB";
+
+/** @brief The version of the format, which changes with the AST. */
+inline constexpr std::uint32_t SERIALIZED_VERSION = 2;
+
+/** @class FormatError
+ * @brief Exception thrown when a serialized program can't be read (or a
+ * program can't be serialized).
+ */
+struct FormatError : public std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+/** @class Serializer
+ * @brief Writes a parsed program in a compact binary format, so it can be
+ * run again without scanning and parsing it.
+ *
+ * @note The format is a header (the magic and the version), the number of
+ * statements, a string table with the text of every lexeme (each one once),
+ * the locations (the size of the source code and where its lines start, if
+ * it was given) and the nodes of the AST in preorder. The integers are
+ * variable-length (7 bits per byte), and the tokens refer to the string
+ * table by index and to their line (and offset in the source) by the
+ * difference with the previous token, so most tokens take 3 bytes (4 with
+ * the locations).
+ * @note The locations let the loaded program report the same columns in its
+ * runtime errors as the parsed one.
+ * @note Only the parsed tree is written (not the annotations of the
+ * optimization passes), so it's optimized again when it's loaded.
+ */
+class Serializer : public ExprVisitor, public StmtVisitor {
+private:
+  std::vector<std::string_view> strings;
+  std::unordered_map<std::string_view, std::uint32_t> indexes;
+  std::string nodes;
+  int line = 0;
+  std::string_view source;
+  std::optional<SourceMap> map;
+  std::uint32_t offset = 0;
+
+  /** @internal
+   * @brief Serializes the program, with the locations if `map` is set.
+   */
+  std::string serializeProgram(
+      const std::vector<std::shared_ptr<Stmt>> &statements);
+
+  void writeByte(std::uint8_t value);
+  void writeInt(std::uint32_t value);
+  void writeString(std::string_view text);
+  void writeToken(const Token &token);
+  void write(const std::shared_ptr<Expr> &expr);
+  void write(const std::shared_ptr<Stmt> &stmt);
+
+  std::any visitBinaryExpr(std::shared_ptr<Binary> expr) override;
+  std::any visitLogicalExpr(std::shared_ptr<Logical> expr) override;
+  std::any visitGroupingExpr(std::shared_ptr<Grouping> expr) override;
+  std::any visitLiteralExpr(std::shared_ptr<Literal> expr) override;
+  std::any visitUnaryExpr(std::shared_ptr<Unary> expr) override;
+  std::any visitAssignExpr(std::shared_ptr<Assign> expr) override;
+  std::any visitVariableExpr(std::shared_ptr<Variable> expr) override;
+  std::any visitBlockStmt(std::shared_ptr<Block> stmt) override;
+  std::any visitExpressionStmt(std::shared_ptr<Expression> stmt) override;
+  std::any visitPrintStmt(std::shared_ptr<Print> stmt) override;
+  std::any visitVarStmt(std::shared_ptr<Var> stmt) override;
+  std::any visitIfStmt(std::shared_ptr<If> stmt) override;
+  std::any visitWhileStmt(std::shared_ptr<While> stmt) override;
+
+public:
+  /** @brief Serializes a parsed program.
+   *
+   * @param statements The statements returned by the Parser (without
+   * errors).
+   *
+   * @return The bytes of the serialized program.
+   * @throws FormatError if a literal has a type the format can't hold.
+   * @note The deferred blocks are parsed (so they throw a RuntimeError if
+   * they have syntax errors).
+   */
+  std::string serialize(const std::vector<std::shared_ptr<Stmt>> &statements);
+
+  /** @brief Serializes a parsed program with the locations of its tokens.
+   *
+   * @param statements The statements returned by the Parser (without
+   * errors).
+   * @param source The source code the statements were parsed from.
+   *
+   * @return The bytes of the serialized program.
+   * @throws FormatError if a literal has a type the format can't hold, or a
+   * token isn't a view into the source.
+   */
+  std::string serialize(const std::vector<std::shared_ptr<Stmt>> &statements,
+                        std::string_view source);
+};
+
+/** @brief Checks if the data starts like a serialized program. */
+bool isSerialized(std::string_view data);
+
+/** @brief Loads a serialized program.
+ *
+ * @param data The bytes written by the Serializer (they must outlive the
+ * returned AST, whose tokens are views into them).
+ *
+ * @return The statements of the program.
+ * @throws FormatError if the data isn't a program of this version, or it's
+ * truncated or corrupted.
+ * @note The tokens are views into the string table, so the serialized
+ * program is read in place (e.g. from a memory-mapped SourceFile) instead of
+ * copying the names. They have no column.
+ */
+std::vector<std::shared_ptr<Stmt>> deserialize(std::string_view data);
+
+/** @brief Loads a serialized program whose source code is known.
+ *
+ * @param data The bytes written by the Serializer, with the locations.
+ * @param source The source code it was serialized from (it must outlive the
+ * returned AST, whose tokens are views into it, as if it was parsed).
+ *
+ * @return The statements of the program.
+ * @throws FormatError if the data has no locations, or they don't match the
+ * source.
+ */
+std::vector<std::shared_ptr<Stmt>> deserialize(std::string_view data,
+                                               std::string_view source);
+
+/** @brief Loads a serialized program without its source code, rebuilding
+ * the parts of it that the tokens need.
+ *
+ * @param data The bytes written by the Serializer.
+ * @param source Where the source is rebuilt: each token at its place, with
+ * spaces instead of the rest of the text (the comments are lost) and the
+ * same lines. It must outlive the returned AST, whose tokens are views into
+ * it, so a SourceMap of it gives the same lines and columns as the original.
+ *
+ * @return The statements of the program.
+ * @throws FormatError if the data isn't a program of this version, or it's
+ * truncated or corrupted.
+ * @note Without locations in the data, the source is left empty and the
+ * tokens are views into the data.
+ */
+std::vector<std::shared_ptr<Stmt>> deserializeRestoring(std::string_view data,
+                                                        std::string &source);
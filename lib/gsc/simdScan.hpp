@@ -0,0 +1,46 @@
+#pragma once
+
+/** @enum SimdLevel
+ * @brief The instruction sets the Scanner can use to skip runs of characters.
+ *
+ * @note SSE2 is always available on x86-64. AVX2 is only used if the CPU
+ * running the program supports it.
+ */
+enum class SimdLevel { SCALAR, SSE2, AVX2 };
+
+/** @struct ScanFunctions
+ * @brief Functions that skip runs of characters many bytes at a time.
+ *
+ * @note Every function receives the position to start from and the end of the
+ * buffer, and returns the position of the first character that isn't part of
+ * the run (or the end of the buffer). The ones that can cross lines add the
+ * number of newlines they skipped to `newlines`.
+ */
+struct ScanFunctions {
+  /** @brief Skips spaces, tabs, carriage returns and newlines. */
+  const char *(*skipWhitespace)(const char *current, const char *end,
+                                int &newlines);
+
+  /** @brief Skips letters, digits and underscores. */
+  const char *(*skipIdentifier)(const char *current, const char *end);
+
+  /** @brief Finds the closing quote of a string. */
+  const char *(*findStringEnd)(const char *current, const char *end,
+                               int &newlines);
+
+  /** @brief Finds the end of a line (used for comments). */
+  const char *(*findLineEnd)(const char *current, const char *end);
+};
+
+/** @brief Returns the best SimdLevel supported by the running CPU.
+ *
+ * @note The CPU features are only checked the first time.
+ */
+SimdLevel detectSimdLevel();
+
+/** @brief Returns the ScanFunctions of the given level.
+ *
+ * @note If the level isn't supported by the build or by the CPU, the best
+ * supported one below it is used.
+ */
+const ScanFunctions &scanFunctions(SimdLevel level = detectSimdLevel());
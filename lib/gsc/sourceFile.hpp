@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/** @class SourceFile
+ * @brief The content of a source file, loaded without copying it if possible.
+ *
+ * @note Regular files are memory-mapped, so the Scanner reads the pages of
+ * the file directly. Anything that can't be mapped (pipes, the standard
+ * input, or if mmap fails) is read into a buffer with read().
+ * @note The Tokens (and the AST) are views into the content, so the
+ * SourceFile must outlive them.
+ */
+class SourceFile {
+private:
+  const char *data = nullptr;
+  std::size_t size = 0;
+  bool mapped = false;
+  std::string buffer;
+
+public:
+  /** @brief Loads a source file.
+   *
+   * @param path The path of the file, or "-" for the standard input.
+   *
+   * @throws std::system_error if the file can't be opened or read.
+   */
+  SourceFile(const std::string &path);
+
+  SourceFile(const SourceFile &) = delete;
+  SourceFile &operator=(const SourceFile &) = delete;
+
+  ~SourceFile();
+
+  std::string_view getContent() const;
+
+  /** @brief Checks if the content is memory-mapped (instead of copied). */
+  bool isMapped() const;
+};
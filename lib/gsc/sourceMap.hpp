@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+/** @struct SourceLocation
+ * @brief A position in the source code (both counted from 1, and the column
+ * in bytes).
+ */
+struct SourceLocation {
+  int line;
+  int column;
+};
+
+/** @class SourceMap
+ * @brief The offsets where the lines of a program start, to find the line
+ * and column of a token from its lexeme.
+ *
+ * @note The lexemes are views into the source code, so their offset is where
+ * they point to, and the tokens don't need to store a column: it's only
+ * computed (in O(log n)) when an error is reported.
+ * @note Lexemes outside the source (e.g. of a loaded serialized program, or
+ * made by the Optimizer) have no location.
+ */
+class SourceMap {
+private:
+  std::string_view source;
+  std::vector<std::size_t> lineStarts;
+
+public:
+  /** @brief Constructs the SourceMap of a program (which must outlive it). */
+  explicit SourceMap(std::string_view source);
+
+  /** @brief Checks if the lexeme is a view into the source. */
+  bool contains(std::string_view lexeme) const;
+
+  /** @brief Returns the location of an offset in the source. */
+  SourceLocation locate(std::size_t offset) const;
+
+  /** @brief Returns the location where the lexeme starts, or nothing if it
+   * isn't a view into the source.
+   */
+  std::optional<SourceLocation> locate(std::string_view lexeme) const;
+
+  /** @brief Returns the offsets where the lines start (the first is 0). */
+  const std::vector<std::size_t> &getLineStarts() const;
+
+  /** @brief Returns the text of a line, without its new line. */
+  std::string_view getLine(int line) const;
+
+  int getLineCount() const;
+};
@@ -2,7 +2,9 @@
 
 #include "gsc/expr.hpp"
 #include <any>
+#include <functional>
 #include <memory>
+#include <span>
 #include <vector>
 
 class Block;
@@ -44,22 +46,63 @@ public:
  * @brief Represents a block of statements.
  *
  * @note This class holds a vector of statements and allows visiting them.
+ * @note A deferred block only holds its tokens (from its '{' to its '}'),
+ * which are parsed the first time its statements are needed, so the blocks
+ * that never run are never parsed (see Parser::setLazyBlocks()).
  */
 class Block : public Stmt, public std::enable_shared_from_this<Block> {
+public:
+  using BodyParser =
+      std::function<std::vector<std::shared_ptr<Stmt>>(std::span<const Token>)>;
+
 private:
-  const std::vector<std::shared_ptr<Stmt>> statements;
+  mutable std::vector<std::shared_ptr<Stmt>> statements;
+  std::span<const Token> tokens;
+  mutable BodyParser parseBody;
 
 public:
   Block(std::vector<std::shared_ptr<Stmt>> statements)
       : statements(std::move(statements)) {}
 
+  /** @brief Constructs a deferred block.
+   *
+   * @param tokens The tokens of the block, braces included (they must
+   * outlive the block).
+   * @param parseBody The function that parses the tokens into the
+   * statements of the block.
+   */
+  Block(std::span<const Token> tokens, BodyParser parseBody)
+      : tokens(tokens), parseBody(std::move(parseBody)) {}
+
   std::any accept(StmtVisitor &visitor) override {
     return visitor.visitBlockStmt(shared_from_this());
   }
 
-  std::vector<std::shared_ptr<Stmt>> getStatements() const {
+  /** @brief Returns the statements of the block, parsing them if the block
+   * is deferred.
+   *
+   * @throws RuntimeError if the tokens of a deferred block have syntax
+   * errors (which are reported first).
+   */
+  const std::vector<std::shared_ptr<Stmt>> &getStatements() const {
+    if (parseBody) {
+      statements = parseBody(tokens);
+      parseBody = nullptr;
+    }
     return statements;
   }
+
+  /** @brief Checks if the statements of the block aren't parsed yet.
+   *
+   * @note The passes that analyze the whole program don't parse deferred
+   * blocks: they assume from the tokens what the statements could do.
+   */
+  bool isDeferred() const { return static_cast<bool>(parseBody); }
+
+  /** @brief Returns the tokens of a block built deferred (or an empty span
+   * if it was built from its statements).
+   */
+  std::span<const Token> getTokens() const { return tokens; }
 };
 
 /** @class Expression
@@ -113,6 +156,7 @@ class Var : public Stmt, public std::enable_shared_from_this<Var> {
 private:
   const Token name;
   std::shared_ptr<Expr> initializer;
+  bool deadStore = false;
 
 public:
   Var(const Token &name, const std::shared_ptr<Expr> &initializer)
@@ -125,6 +169,10 @@ public:
   Token getName() const { return name; }
 
   std::shared_ptr<Expr> getInitializer() const { return initializer; }
+
+  /** @brief Checks if the initial value is never read (set by Liveness). */
+  bool isDeadStore() const { return deadStore; }
+  void setDeadStore(bool dead) { deadStore = dead; }
 };
 
 /** @class If
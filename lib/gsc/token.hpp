@@ -3,6 +3,7 @@
 #include "tokenType.hpp"
 #include <any>
 #include <string>
+#include <string_view>
 
 /** @class Token
  * @brief Represents a token in the source code.
@@ -10,13 +11,20 @@
  * The Token class encapsulates the type, lexeme, literal value, and line number
  * of a token. It provides a method to convert the token to a string
  * representation.
+ *
+ * @note The lexeme is a view into the source code, so the source must outlive
+ * the token (and the AST built from it).
+ * @note The tokens of the Scanner don't allocate memory: their literal is
+ * empty and decoded from the lexeme when it's needed. A literal passed to the
+ * constructor is stored in a std::any, which allocates if it's too large for
+ * its small buffer (e.g. a std::string).
  */
 class Token {
 private:
   const TokenType type;
-  const std::string lexeme;
-  const std::any literal;
   const int line;
+  const std::string_view lexeme;
+  const std::any literal;
 
 public:
   /** @brief Constructs a Token object.
@@ -27,18 +35,41 @@ public:
    * @param line The line number where the token was found.
    *
    * @note The literal value can be of any type, so it is stored as std::any.
-   * @note The lexeme and literal values are moved into the object to avoid
-   * copying.
+   * @note The literal value is moved into the object to avoid copying.
+   */
+  Token(TokenType type, std::string_view lexeme, std::any literal, int line);
+
+  /** @brief Constructs a Token whose literal value is decoded from the
+   * lexeme when it's needed (used by the Scanner).
+   *
+   * @param type The type of the token.
+   * @param lexeme The lexeme of the token.
+   * @param line The line number where the token was found.
    */
-  Token(TokenType type, std::string lexeme, std::any literal, int line);
+  Token(TokenType type, std::string_view lexeme, int line);
 
   TokenType getType() const;
 
-  std::string getLexeme() const;
+  std::string_view getLexeme() const;
 
+  /** @brief Returns the literal value of the token.
+   *
+   * @note If the token was built without one, NUMBER and STRING tokens decode
+   * it from the lexeme (the number, or the text between the quotes), and the
+   * other tokens return nil.
+   * @throws std::out_of_range if a NUMBER doesn't fit in an int.
+   */
   std::any getLiteral() const;
 
   int getLine() const;
 
+  /** @brief Returns the same token with its lexeme in another buffer (e.g. an
+   * edited copy of the source code) and on another line.
+   *
+   * @param lexeme The lexeme in the other buffer, with the same text.
+   * @param line The new line number of the token.
+   */
+  Token relocate(std::string_view lexeme, int line) const;
+
   std::string toString() const;
 };
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "gsc/expr.hpp"
+#include "gsc/stmt.hpp"
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/** @enum InferredType
+ * @brief Lattice of the types that the TypeInference pass can prove.
+ *
+ * @note UNDEFINED is the bottom of the lattice (no value seen yet) and ANY is
+ * the top (the value can have more than one type at runtime).
+ */
+enum class InferredType { UNDEFINED, NIL, BOOL, INT, STRING, ANY };
+
+/** @brief Returns the name of an inferred type as shown in the type dump. */
+std::string toString(InferredType type);
+
+/** @class TypeInference
+ * @brief Flow-sensitive type inference pass for SC programs.
+ *
+ * @note It walks the AST tracking the type of every variable in scope, joins
+ * the states of both branches of an `if` and iterates `while` loops until a
+ * fixpoint is reached. Binary expressions whose operands are proven to be
+ * always `int` or always `string` are annotated with an OperandType, so the
+ * Interpreter can skip the runtime type checks on them.
+ * @note The state isn't copied for each branch: the changes of the slots are
+ * kept in a trail, undone at the end of a branch and only the changed slots
+ * are joined. So a branch costs as much as the assignments in it, not as the
+ * number of variables in scope.
+ * @note Variables that aren't declared in the analyzed program (e.g. globals
+ * of a previous REPL line) are considered of ANY type.
+ * @note Deferred blocks (see Parser::setLazyBlocks()) aren't parsed: the
+ * variables assigned in their tokens are considered of ANY type after them,
+ * and their binary expressions keep the runtime checks.
+ */
+class TypeInference : public ExprVisitor, public StmtVisitor {
+private:
+  /** @internal
+   * @brief State of a variable slot in the current scope chain.
+   */
+  struct Slot {
+    InferredType type;
+    int declaration;
+
+    bool operator==(const Slot &other) const = default;
+  };
+
+  /** @internal
+   * @brief A variable declaration and the join of all the values written to
+   * it.
+   */
+  struct Declaration {
+    std::string name;
+    int line;
+    InferredType type;
+  };
+
+  /** @internal
+   * @brief A change of a slot, with its previous value (nullopt if it wasn't
+   * declared) to undo it.
+   *
+   * @note The name is a view into the tokens of the analyzed program.
+   */
+  struct Change {
+    std::size_t scope;
+    std::string_view name;
+    std::optional<Slot> previous;
+  };
+
+  /** @internal
+   * @brief Slots (by scope and name) changed since a point of the trail,
+   * each with a value.
+   */
+  using Changes =
+      std::map<std::pair<std::size_t, std::string_view>, std::optional<Slot>>;
+
+  std::vector<std::map<std::string, Slot, std::less<>>> scopes;
+  std::vector<Change> trail;
+  std::vector<Declaration> declarations;
+  std::map<Var *, int> declarationIds;
+  std::map<Binary *, OperandType> operandTypes;
+
+  InferredType infer(std::shared_ptr<Expr> expr);
+  void analyze(std::shared_ptr<Stmt> stmt);
+
+  Slot *lookup(std::string_view name);
+  void write(std::string_view name, InferredType type);
+
+  /** @internal
+   * @brief Returns the value of a slot, or nullopt if it isn't declared.
+   */
+  std::optional<Slot> get(std::size_t scope, std::string_view name) const;
+
+  /** @internal
+   * @brief Changes a slot (nullopt removes it) and records it in the trail.
+   */
+  void set(std::size_t scope, std::string_view name, std::optional<Slot> slot);
+
+  /** @internal
+   * @brief Changes a slot without recording it.
+   */
+  void replace(std::size_t scope, std::string_view name,
+               const std::optional<Slot> &slot);
+
+  /** @internal
+   * @brief Returns the slots changed since the given size of the trail, with
+   * their value at that point.
+   */
+  Changes changedSince(std::size_t mark) const;
+
+  /** @internal
+   * @brief Returns the slots changed since the given size of the trail, with
+   * their current value.
+   */
+  Changes currentSince(std::size_t mark) const;
+
+  /** @internal
+   * @brief Undoes the changes made since the given size of the trail.
+   */
+  void undo(std::size_t mark);
+
+  static InferredType join(InferredType a, InferredType b);
+
+  /** @internal
+   * @brief Joins the values of a slot at two points of the program.
+   *
+   * @note A slot that is only declared in one of them, or for different
+   * declarations, can hold any type. The result keeps the declaration of
+   * `a` when it has one.
+   */
+  static std::optional<Slot> join(const std::optional<Slot> &a,
+                                  const std::optional<Slot> &b);
+
+  std::any visitBinaryExpr(std::shared_ptr<Binary> expr) override;
+  std::any visitLogicalExpr(std::shared_ptr<Logical> expr) override;
+  std::any visitGroupingExpr(std::shared_ptr<Grouping> expr) override;
+  std::any visitLiteralExpr(std::shared_ptr<Literal> expr) override;
+  std::any visitUnaryExpr(std::shared_ptr<Unary> expr) override;
+  std::any visitAssignExpr(std::shared_ptr<Assign> expr) override;
+  std::any visitVariableExpr(std::shared_ptr<Variable> expr) override;
+  std::any visitBlockStmt(std::shared_ptr<Block> stmt) override;
+  std::any visitExpressionStmt(std::shared_ptr<Expression> stmt) override;
+  std::any visitPrintStmt(std::shared_ptr<Print> stmt) override;
+  std::any visitIfStmt(std::shared_ptr<If> stmt) override;
+  std::any visitWhileStmt(std::shared_ptr<While> stmt) override;
+  std::any visitVarStmt(std::shared_ptr<Var> stmt) override;
+
+public:
+  /** @brief
+   * Infer the types of the given program and annotate its binary expressions.
+   *
+   * @param statements The statements of the program to analyze.
+   *
+   * @note Previous results of this object are discarded.
+   */
+  void analyze(const std::vector<std::shared_ptr<Stmt>> &statements);
+
+  /** @brief
+   * Write the inferred type of each declared variable to the given stream.
+   *
+   * @param out The stream where the dump is written.
+   *
+   * @note Each line has the format `name (line N): type`, followed by a final
+   * line telling if the whole program is monomorphic.
+   */
+  void dump(std::ostream &out) const;
+
+  /** @brief
+   * Check if every declared variable holds values of a single type.
+   *
+   * @return true if no variable was inferred as ANY.
+   */
+  bool isMonomorphic() const;
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string_view>
+
+/** @brief The version of the interpreter.
+ *
+ * @note It's part of the key of the programs in the CompileCache, so it must
+ * change whenever the Parser builds a different AST from the same source
+ * (e.g. a new desugaring), even if the serialized format doesn't change.
+ */
+inline constexpr std::string_view GSC_VERSION = "0.5.0";
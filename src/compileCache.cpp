@@ -0,0 +1,272 @@
+#include "gsc/compileCache.hpp"
+#include "gsc/hash.hpp"
+#include "gsc/serializer.hpp"
+#include "gsc/sourceFile.hpp"
+#include "gsc/version.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <string>
+#include <sys/file.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace {
+
+/** @internal
+ * @brief The first bytes of an entry, before the serialized program.
+ */
+constexpr std::string_view ENTRY_MAGIC = "GSCC";
+
+void appendInt64(std::string &bytes, std::uint64_t value) {
+  for (int i = 0; i < 8; i++, value >>= 8) {
+    bytes.push_back(static_cast<char>(value & 0xFF));
+  }
+}
+
+/** @internal
+ * @brief Returns the header of the entry of a program: the magic, the size
+ * of the source and its checksum, which tell apart two programs with the
+ * same key.
+ */
+std::string entryHeader(std::string_view source) {
+  std::string header{ENTRY_MAGIC};
+  appendInt64(header, source.size());
+  appendInt64(header, checksumBytes(source));
+  return header;
+}
+
+std::string toHex(std::uint64_t value) {
+  std::string hex(16, '0');
+  for (int i = 15; i >= 0; i--, value >>= 4) {
+    hex[i] = "0123456789abcdef"[value & 0xF];
+  }
+  return hex;
+}
+
+/** @internal
+ * @struct Entry
+ * @brief A file of the cache directory, for the eviction.
+ */
+struct Entry {
+  std::filesystem::path path;
+  std::uintmax_t size;
+  std::filesystem::file_time_type lastUse;
+};
+
+std::vector<Entry> listEntries(const std::filesystem::path &directory) {
+  std::vector<Entry> entries;
+  std::error_code error;
+  for (std::filesystem::directory_iterator it{directory, error}, end;
+       !error && it != end; it.increment(error)) {
+    std::error_code entryError;
+    if (it->path().extension() != ".scb" || !it->is_regular_file(entryError)) {
+      continue;
+    }
+    std::uintmax_t size = it->file_size(entryError);
+    std::filesystem::file_time_type lastUse =
+        it->last_write_time(entryError);
+    if (!entryError) {
+      entries.push_back({it->path(), size, lastUse});
+    }
+  }
+  return entries;
+}
+
+/** @internal
+ * @brief Reads the counters of an open statistics file (or zeros).
+ */
+CompileCache::Statistics readCounters(int fd) {
+  CompileCache::Statistics statistics;
+  std::string text;
+  char buffer[256];
+  ssize_t size;
+  while ((size = pread(fd, buffer, sizeof(buffer), text.size())) > 0) {
+    text.append(buffer, size);
+  }
+  if (std::sscanf(text.c_str(), "%ju %ju %ju", &statistics.hits,
+                  &statistics.misses, &statistics.evictions) != 3) {
+    statistics = {};
+  }
+  return statistics;
+}
+
+} // namespace
+
+CompileCache::CompileCache(std::filesystem::path directory,
+                           std::uintmax_t maxSize)
+    : directory(std::move(directory)), maxSize(maxSize) {}
+
+std::filesystem::path CompileCache::defaultDirectory() {
+  if (const char *path = std::getenv("GSC_CACHE_DIR")) {
+    return path;
+  } else if (const char *path = std::getenv("XDG_CACHE_HOME")) {
+    return std::filesystem::path{path} / "gsc";
+  } else if (const char *path = std::getenv("HOME")) {
+    return std::filesystem::path{path} / ".cache" / "gsc";
+  }
+  return {};
+}
+
+std::filesystem::path
+CompileCache::entryPath(std::string_view source) const {
+  // A new interpreter or format has other keys, instead of reading the
+  // entries of the old one
+  std::uint64_t hash =
+      hashBytes(source, hashBytes("gsc " + std::string{GSC_VERSION} + " " +
+                                  std::to_string(SERIALIZED_VERSION) + "\n"));
+  return directory /
+         (toHex(hash) + "-" + std::to_string(source.size()) + ".scb");
+}
+
+std::optional<std::vector<std::shared_ptr<Stmt>>>
+CompileCache::load(std::string_view source) {
+  std::filesystem::path path = entryPath(source);
+
+  try {
+    SourceFile entry{path.string()};
+    std::string header = entryHeader(source);
+    std::string_view content = entry.getContent();
+    if (content.size() < header.size() || !content.starts_with(ENTRY_MAGIC)) {
+      throw FormatError("Invalid cache entry");
+    } else if (!content.starts_with(header)) {
+      // Another program with the same key (the next store() replaces it)
+      count(0, 1, 0);
+      return std::nullopt;
+    }
+    std::vector<std::shared_ptr<Stmt>> statements =
+        deserialize(content.substr(header.size()), source);
+
+    // The modification time of an entry is its last use
+    std::error_code error;
+    std::filesystem::last_write_time(
+        path, std::filesystem::file_time_type::clock::now(), error);
+    count(1, 0, 0);
+    return statements;
+  } catch (const std::system_error &) {
+    // The program isn't cached
+  } catch (const FormatError &) {
+    std::error_code error;
+    std::filesystem::remove(path, error);
+  }
+
+  count(0, 1, 0);
+  return std::nullopt;
+}
+
+void CompileCache::store(
+    std::string_view source,
+    const std::vector<std::shared_ptr<Stmt>> &statements) {
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+  if (error) {
+    return;
+  }
+
+  std::string data = entryHeader(source);
+  try {
+    data += Serializer{}.serialize(statements, source);
+  } catch (const FormatError &) {
+    return;
+  }
+  if (data.size() > maxSize) {
+    return;
+  }
+
+  // Other processes only see complete entries
+  std::filesystem::path path = entryPath(source);
+  std::filesystem::path temporary = path;
+  temporary += ".tmp" + std::to_string(getpid());
+  {
+    std::ofstream file{temporary, std::ios::binary};
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file.flush()) {
+      file.close();
+      std::filesystem::remove(temporary, error);
+      return;
+    }
+  }
+  std::filesystem::rename(temporary, path, error);
+  if (error) {
+    std::filesystem::remove(temporary, error);
+    return;
+  }
+
+  if (std::uintmax_t evictions = evict()) {
+    count(0, 0, evictions);
+  }
+}
+
+std::uintmax_t CompileCache::evict() {
+  std::vector<Entry> entries = listEntries(directory);
+  std::uintmax_t size = 0;
+  for (const Entry &entry : entries) {
+    size += entry.size;
+  }
+  if (size <= maxSize) {
+    return 0;
+  }
+
+  std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+    return a.lastUse < b.lastUse;
+  });
+  std::uintmax_t evictions = 0;
+  for (const Entry &entry : entries) {
+    if (size <= maxSize) {
+      break;
+    }
+    std::error_code error;
+    if (std::filesystem::remove(entry.path, error)) {
+      size -= entry.size;
+      evictions++;
+    }
+  }
+  return evictions;
+}
+
+void CompileCache::count(std::uintmax_t hits, std::uintmax_t misses,
+                         std::uintmax_t evictions) {
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+  if (error) {
+    return;
+  }
+
+  // The file is locked, so concurrent runs don't lose their updates
+  std::filesystem::path path = directory / "statistics";
+  int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return;
+  }
+  if (flock(fd, LOCK_EX) == 0) {
+    Statistics statistics = readCounters(fd);
+    std::string text = std::to_string(statistics.hits + hits) + " " +
+                       std::to_string(statistics.misses + misses) + " " +
+                       std::to_string(statistics.evictions + evictions) +
+                       "\n";
+    if (pwrite(fd, text.data(), text.size(), 0) ==
+        static_cast<ssize_t>(text.size())) {
+      [[maybe_unused]] int truncated = ftruncate(fd, text.size());
+    }
+  }
+  close(fd);
+}
+
+CompileCache::Statistics CompileCache::getStatistics() const {
+  Statistics statistics;
+  std::filesystem::path path = directory / "statistics";
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd >= 0) {
+    if (flock(fd, LOCK_SH) == 0) {
+      statistics = readCounters(fd);
+    }
+    close(fd);
+  }
+  for (const Entry &entry : listEntries(directory)) {
+    statistics.entries++;
+    statistics.size += entry.size;
+  }
+  return statistics;
+}
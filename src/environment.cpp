@@ -6,7 +6,7 @@ Environment::Environment() : enclosing(nullptr) {}
 Environment::Environment(std::shared_ptr<Environment> enclosing)
     : enclosing(std::move(enclosing)) {}
 
-std::any Environment::get(const Token &name) const {
+const std::any &Environment::get(const Token &name) const {
   auto it = values.find(name.getLexeme());
   if (it != values.end()) {
     return it->second;
@@ -15,7 +15,23 @@ std::any Environment::get(const Token &name) const {
     return enclosing->get(name);
   }
   throw RuntimeError(std::make_shared<Token>(name),
-                     "Undefined variable '" + name.getLexeme() + "'.");
+                     "Undefined variable '" + std::string{name.getLexeme()} +
+                         "'.");
+}
+
+std::any Environment::take(const Token &name) {
+  auto it = values.find(name.getLexeme());
+  if (it != values.end()) {
+    std::any value = std::move(it->second);
+    it->second = nullptr;
+    return value;
+  }
+  if (enclosing) {
+    return enclosing->take(name);
+  }
+  throw RuntimeError(std::make_shared<Token>(name),
+                     "Undefined variable '" + std::string{name.getLexeme()} +
+                         "'.");
 }
 
 void Environment::assign(const Token &name, std::any value) {
@@ -29,9 +45,15 @@ void Environment::assign(const Token &name, std::any value) {
     return;
   }
   throw RuntimeError(std::make_shared<Token>(name),
-                     "Undefined variable '" + name.getLexeme() + "'.");
+                     "Undefined variable '" + std::string{name.getLexeme()} +
+                         "'.");
 }
 
-void Environment::define(const std::string &name, std::any value) {
-  values[name] = std::move(value);
+void Environment::define(std::string_view name, std::any value) {
+  auto it = values.find(name);
+  if (it != values.end()) {
+    it->second = std::move(value);
+  } else {
+    values.emplace(name, std::move(value));
+  }
 }
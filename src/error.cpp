@@ -1,10 +1,68 @@
 #include "gsc/error.hpp"
 #include <iostream>
 
+namespace {
+
+std::string location(const Token &token) {
+  if (token.getType() == TokenType::END_OF_FILE) {
+    return "at end";
+  }
+  return "at '" + std::string{token.getLexeme()} + "'";
+}
+
+} // namespace
+
+DiagnosticList::DiagnosticList(std::size_t limit) : limit(limit) {}
+
+void DiagnosticList::add(int line, const std::string &where,
+                         const std::string &message) {
+  if (isFull()) {
+    dropped++;
+  } else {
+    diagnostics.push_back({line, where, message});
+  }
+}
+
+void DiagnosticList::add(const Token &token, const std::string &message) {
+  // Don't format the location of an error that is only counted
+  add(token.getLine(), isFull() ? "" : location(token), message);
+}
+
+bool DiagnosticList::isFull() const { return diagnostics.size() >= limit; }
+
+std::size_t DiagnosticList::getLimit() const { return limit; }
+
+const std::vector<Diagnostic> &DiagnosticList::getDiagnostics() const {
+  return diagnostics;
+}
+
+void DiagnosticList::merge(const DiagnosticList &other) {
+  for (const Diagnostic &diagnostic : other.diagnostics) {
+    add(diagnostic.line, diagnostic.where, diagnostic.message);
+  }
+  dropped += other.dropped;
+}
+
+std::size_t DiagnosticList::getDropped() const { return dropped; }
+
+void DiagnosticList::print(std::ostream &out) const {
+  for (const Diagnostic &diagnostic : diagnostics) {
+    out << "[line " << diagnostic.line << "] Error " << diagnostic.where
+        << ": " << diagnostic.message << "\n";
+  }
+  if (dropped > 0) {
+    out << "... and " << dropped << " more errors.\n";
+  }
+}
+
 void report(const int &line, const std::string &where,
             const std::string &message) {
-  std::cerr << "[line " << line << "] Error " << where << ": " << message
-            << "\n";
+  if (diagnosticSink) {
+    diagnosticSink->add(line, where, message);
+  } else {
+    std::cerr << "[line " << line << "] Error " << where << ": " << message
+              << "\n";
+  }
 
   hadError = true;
 }
@@ -14,15 +72,40 @@ void error(const int &line, const std::string &message) {
 }
 
 void error(const Token &token, const std::string &message) {
-  if (token.getType() == TokenType::END_OF_FILE) {
-    report(token.getLine(), "at end", message);
+  if (diagnosticSink) {
+    diagnosticSink->add(token, message);
+    hadError = true;
   } else {
-    report(token.getLine(), "at '" + token.getLexeme() + "'", message);
+    report(token.getLine(), location(token), message);
   }
 }
 
+void report(const DiagnosticList &diagnostics) {
+  if (diagnostics.getDiagnostics().empty() && diagnostics.getDropped() == 0) {
+    return;
+  }
+
+  if (diagnosticSink) {
+    diagnosticSink->merge(diagnostics);
+  } else {
+    diagnostics.print(std::cerr);
+  }
+  hadError = true;
+}
+
 void runtimeError(const RuntimeError &error) {
-  std::cerr << error.getMessage() << "\n[line " << error.getToken()->getLine()
-            << "]" << std::endl;
+  const Token &token = *error.getToken();
+  std::optional<SourceLocation> location;
+  if (sourceMap) {
+    location = sourceMap->locate(token.getLexeme());
+  }
+
+  std::cerr << error.getMessage() << "\n[line ";
+  if (location) {
+    std::cerr << location->line << ", column " << location->column;
+  } else {
+    std::cerr << token.getLine();
+  }
+  std::cerr << "]" << std::endl;
   hadRuntimeError = true;
 }
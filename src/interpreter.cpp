@@ -18,10 +18,33 @@ std::any Interpreter::evaluate(std::shared_ptr<Expr> expr) {
   return expr->accept(*this);
 }
 
+const std::any &Interpreter::evaluateInPlace(const std::shared_ptr<Expr> &expr,
+                                             std::any &temporary) {
+  if (auto literal = dynamic_cast<Literal *>(expr.get())) {
+    return literal->getValue();
+  }
+  if (auto variable = dynamic_cast<Variable *>(expr.get());
+      variable && !variable->isLastUse()) {
+    return environment->get(variable->getName());
+  }
+  temporary = evaluate(expr);
+  return temporary;
+}
+
+bool Interpreter::preserves(const std::shared_ptr<Expr> &expr,
+                            const Token &name) const {
+  if (dynamic_cast<Literal *>(expr.get())) {
+    return true;
+  }
+  auto variable = dynamic_cast<Variable *>(expr.get());
+  return variable && (!variable->isLastUse() ||
+                      variable->getName().getLexeme() != name.getLexeme());
+}
+
 void Interpreter::execute(std::shared_ptr<Stmt> stmt) { stmt->accept(*this); }
 
 void Interpreter::executeBlock(
-    const std::vector<std::shared_ptr<Stmt>> statements,
+    const std::vector<std::shared_ptr<Stmt>> &statements,
     std::shared_ptr<Environment> environment) {
   std::shared_ptr<Environment> previous = this->environment;
   try {
@@ -39,7 +62,8 @@ void Interpreter::executeBlock(
 }
 
 template <class... N>
-void Interpreter::checkNumberOperands(const Token &op, N... operands) {
+void Interpreter::checkNumberOperands(const Token &op,
+                                      const N &...operands) {
   if (((operands.type() != typeid(int)) && ...)) {
     throw RuntimeError(std::make_shared<Token>(op),
                        "Operands must be numbers.");
@@ -52,8 +76,8 @@ bool Interpreter::isTruthy(const std::any &value) const {
   } else if (value.type() == typeid(int)) {
     return std::any_cast<int>(value) != 0; // Non-zero integers are truthy
   } else if (value.type() == typeid(std::string)) {
-    return !std::any_cast<std::string>(value)
-                .empty(); // Non-empty strings are truthy
+    return !std::any_cast<std::string>(&value)
+                ->empty(); // Non-empty strings are truthy
   } else if (value.type() == typeid(bool)) {
     return std::any_cast<bool>(value);
   }
@@ -70,7 +94,7 @@ bool Interpreter::isEqual(const std::any &a, const std::any &b) const {
   } else if (a.type() == typeid(int)) {
     return std::any_cast<int>(a) == std::any_cast<int>(b);
   } else if (a.type() == typeid(std::string)) {
-    return std::any_cast<std::string>(a) == std::any_cast<std::string>(b);
+    return *std::any_cast<std::string>(&a) == *std::any_cast<std::string>(&b);
   } else {
     return false; // Unsupported types
   }
@@ -101,7 +125,8 @@ std::any Interpreter::visitLiteralExpr(std::shared_ptr<Literal> expr) {
 }
 
 std::any Interpreter::visitUnaryExpr(std::shared_ptr<Unary> expr) {
-  std::any right = evaluate(expr->getRight());
+  std::any rightValue;
+  const std::any &right = evaluateInPlace(expr->getRight(), rightValue);
   Token op = expr->getOp();
 
   switch (op.getType()) {
@@ -118,9 +143,37 @@ std::any Interpreter::visitUnaryExpr(std::shared_ptr<Unary> expr) {
 }
 
 std::any Interpreter::visitBinaryExpr(std::shared_ptr<Binary> expr) {
-  std::any left = evaluate(expr->getLeft());
-  std::any right = evaluate(expr->getRight());
-  Token op = expr->getOp();
+  std::any leftValue;
+  std::any rightValue;
+  const Token &op = expr->getOp();
+
+  // A variable on the left can only be read in place if evaluating the right
+  // operand doesn't assign or release it
+  auto variable = dynamic_cast<Variable *>(expr->getLeft().get());
+  const std::any &left =
+      variable && preserves(expr->getRight(), variable->getName())
+          ? evaluateInPlace(expr->getLeft(), leftValue)
+          : (leftValue = evaluate(expr->getLeft()));
+  const std::any &right = evaluateInPlace(expr->getRight(), rightValue);
+
+  // An owned left string (a temporary or a variable on its last use) is
+  // appended to in place instead of being copied
+  if (op.getType() == TokenType::PLUS && &left == &leftValue &&
+      right.type() == typeid(std::string)) {
+    if (auto text = std::any_cast<std::string>(&leftValue)) {
+      *text += *std::any_cast<std::string>(&right);
+      return leftValue;
+    }
+  }
+
+  // Operand types proven by TypeInference don't need to be checked again
+  if (expr->getOperandType() == OperandType::INT) {
+    return evaluateIntBinary(op, *std::any_cast<int>(&left),
+                             *std::any_cast<int>(&right));
+  } else if (expr->getOperandType() == OperandType::STRING) {
+    return evaluateStringBinary(op, *std::any_cast<std::string>(&left),
+                                *std::any_cast<std::string>(&right));
+  }
 
   switch (op.getType()) {
   case TokenType::PLUS:
@@ -128,8 +181,8 @@ std::any Interpreter::visitBinaryExpr(std::shared_ptr<Binary> expr) {
       return std::any_cast<int>(left) + std::any_cast<int>(right);
     } else if (left.type() == typeid(std::string) &&
                right.type() == typeid(std::string)) {
-      return std::any_cast<std::string>(left) +
-             std::any_cast<std::string>(right);
+      return *std::any_cast<std::string>(&left) +
+             *std::any_cast<std::string>(&right);
     } else {
       throw RuntimeError(std::make_shared<Token>(op),
                          "Operands must be two numbers or two strings.");
@@ -169,6 +222,55 @@ std::any Interpreter::visitBinaryExpr(std::shared_ptr<Binary> expr) {
   }
 }
 
+std::any Interpreter::evaluateIntBinary(const Token &op, int left,
+                                        int right) const {
+  switch (op.getType()) {
+  case TokenType::PLUS:
+    return left + right;
+  case TokenType::MINUS:
+    return left - right;
+  case TokenType::STAR:
+    return left * right;
+  case TokenType::SLASH:
+    if (right == 0) {
+      throw RuntimeError(std::make_shared<Token>(op), "Division by zero.");
+    }
+    return left / right;
+  case TokenType::GREATER:
+    return left > right;
+  case TokenType::GREATER_EQUAL:
+    return left >= right;
+  case TokenType::LESS:
+    return left < right;
+  case TokenType::LESS_EQUAL:
+    return left <= right;
+  case TokenType::EQUAL_EQUAL:
+    return left == right;
+  case TokenType::BANG_EQUAL:
+    return left != right;
+  default:
+    // This should never be reached, but just in case
+    assert(false && "Unknown binary operator");
+    return {};
+  }
+}
+
+std::any Interpreter::evaluateStringBinary(const Token &op,
+                                           const std::string &left,
+                                           const std::string &right) const {
+  switch (op.getType()) {
+  case TokenType::PLUS:
+    return left + right;
+  case TokenType::EQUAL_EQUAL:
+    return left == right;
+  case TokenType::BANG_EQUAL:
+    return left != right;
+  default:
+    throw RuntimeError(std::make_shared<Token>(op),
+                       "Operands must be numbers.");
+  }
+}
+
 std::any Interpreter::visitLogicalExpr(std::shared_ptr<Logical> expr) {
   std::any left = evaluate(expr->getLeft());
   Token op = expr->getOp();
@@ -182,13 +284,26 @@ std::any Interpreter::visitLogicalExpr(std::shared_ptr<Logical> expr) {
   return evaluate(expr->getRight());
 }
 
-std::any Interpreter::visitAssignExpr(std::shared_ptr<Assign> expr) {
-  std::any value = evaluate(expr->getValue());
-  environment->assign(expr->getName(), value);
+std::any Interpreter::assign(Assign &expr, bool discarded) {
+  std::any value = evaluate(expr.getValue());
+  if (discarded) {
+    environment->assign(expr.getName(), expr.isDeadStore() ? std::any{nullptr}
+                                                           : std::move(value));
+    return {};
+  }
+  environment->assign(expr.getName(),
+                      expr.isDeadStore() ? std::any{nullptr} : value);
   return value;
 }
 
+std::any Interpreter::visitAssignExpr(std::shared_ptr<Assign> expr) {
+  return assign(*expr, false);
+}
+
 std::any Interpreter::visitVariableExpr(std::shared_ptr<Variable> expr) {
+  if (expr->isLastUse()) {
+    return environment->take(expr->getName());
+  }
   return environment->get(expr->getName());
 }
 
@@ -199,19 +314,31 @@ std::any Interpreter::visitBlockStmt(std::shared_ptr<Block> stmt) {
 }
 
 std::any Interpreter::visitExpressionStmt(std::shared_ptr<Expression> stmt) {
+  // The result of an assignment statement is discarded, so the value can be
+  // moved into the environment instead of copied
+  if (auto expr = dynamic_cast<Assign *>(stmt->getExpression().get())) {
+    assign(*expr, true);
+    return {};
+  }
+
   evaluate(stmt->getExpression());
   return {};
 }
 
 std::any Interpreter::visitPrintStmt(std::shared_ptr<Print> stmt) {
-  std::any value = evaluate(stmt->getExpression());
-  std::cout << stringify(value) << std::endl;
+  std::any temporary;
+  const std::any &value = evaluateInPlace(stmt->getExpression(), temporary);
+  if (auto text = std::any_cast<std::string>(&value)) {
+    std::cout << *text << std::endl; // Printed without copying it
+  } else {
+    std::cout << stringify(value) << std::endl;
+  }
   return {};
 }
 
 std::any Interpreter::visitIfStmt(std::shared_ptr<If> stmt) {
-  std::any condition = evaluate(stmt->getCondition());
-  if (isTruthy(condition)) {
+  std::any temporary;
+  if (isTruthy(evaluateInPlace(stmt->getCondition(), temporary))) {
     execute(stmt->getThenBranch());
   } else if (stmt->getElseBranch()) {
     execute(stmt->getElseBranch());
@@ -220,7 +347,8 @@ std::any Interpreter::visitIfStmt(std::shared_ptr<If> stmt) {
 }
 
 std::any Interpreter::visitWhileStmt(std::shared_ptr<While> stmt) {
-  while (isTruthy(evaluate(stmt->getCondition()))) {
+  std::any temporary;
+  while (isTruthy(evaluateInPlace(stmt->getCondition(), temporary))) {
     execute(stmt->getBody());
   }
   return {};
@@ -231,6 +359,9 @@ std::any Interpreter::visitVarStmt(std::shared_ptr<Var> stmt) {
   if (stmt->getInitializer()) {
     value = evaluate(stmt->getInitializer());
   }
+  if (stmt->isDeadStore()) {
+    value = nullptr; // Never read, so it's released right away
+  }
   environment->define(stmt->getName().getLexeme(), std::move(value));
   return {};
 }
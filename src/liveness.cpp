@@ -0,0 +1,467 @@
+#include "gsc/liveness.hpp"
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace {
+
+constexpr int UNRESOLVED = -1;
+
+/** @internal
+ * @class SlotResolver
+ * @brief Resolves each variable reference to the slot (the storage in an
+ * Environment) it reads or writes.
+ *
+ * @note A node that is shared between different places of the tree (e.g. by
+ * the LoopUnroller) and resolves to different slots is left unresolved.
+ */
+class SlotResolver : public ExprVisitor, public StmtVisitor {
+private:
+  std::vector<std::map<std::string, int, std::less<>>> scopes;
+  std::vector<Block *> blocks;
+  std::map<Var *, int> declarationSlots;
+
+  void resolve(const std::shared_ptr<Expr> &expr) { expr->accept(*this); }
+
+  void resolve(const std::shared_ptr<Stmt> &stmt) {
+    if (stmt) {
+      stmt->accept(*this);
+    }
+  }
+
+  void record(const void *node, int slot) {
+    auto [it, inserted] = slots.try_emplace(node, slot);
+    if (!inserted && it->second != slot) {
+      it->second = UNRESOLVED;
+    }
+  }
+
+  int lookup(std::string_view name) const {
+    for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
+      auto it = scope->find(name);
+      if (it != scope->end()) {
+        return it->second;
+      }
+    }
+    return UNRESOLVED;
+  }
+
+public:
+  std::map<const void *, int> slots;
+  std::map<Block *, std::vector<int>> blockSlots;
+  std::map<Block *, std::vector<int>> deferredReads;
+  std::vector<bool> globals;
+
+  SlotResolver(const std::vector<std::shared_ptr<Stmt>> &statements)
+      : scopes(1), blocks(1, nullptr) {
+    for (const std::shared_ptr<Stmt> &stmt : statements) {
+      resolve(stmt);
+    }
+  }
+
+  int slotOf(const void *node) const {
+    auto it = slots.find(node);
+    return it == slots.end() ? UNRESOLVED : it->second;
+  }
+
+  std::any visitBinaryExpr(std::shared_ptr<Binary> expr) override {
+    resolve(expr->getLeft());
+    resolve(expr->getRight());
+    return {};
+  }
+
+  std::any visitLogicalExpr(std::shared_ptr<Logical> expr) override {
+    resolve(expr->getLeft());
+    resolve(expr->getRight());
+    return {};
+  }
+
+  std::any visitGroupingExpr(std::shared_ptr<Grouping> expr) override {
+    resolve(expr->getExpression());
+    return {};
+  }
+
+  std::any visitLiteralExpr(std::shared_ptr<Literal>) override { return {}; }
+
+  std::any visitUnaryExpr(std::shared_ptr<Unary> expr) override {
+    resolve(expr->getRight());
+    return {};
+  }
+
+  std::any visitAssignExpr(std::shared_ptr<Assign> expr) override {
+    resolve(expr->getValue());
+    record(expr.get(), lookup(expr->getName().getLexeme()));
+    return {};
+  }
+
+  std::any visitVariableExpr(std::shared_ptr<Variable> expr) override {
+    record(expr.get(), lookup(expr->getName().getLexeme()));
+    return {};
+  }
+
+  std::any visitBlockStmt(std::shared_ptr<Block> stmt) override {
+    if (stmt->isDeferred()) {
+      // Any variable named in the block may be read by it
+      std::vector<int> &reads = deferredReads[stmt.get()];
+      for (const Token &token : stmt->getTokens()) {
+        int slot = token.getType() == TokenType::IDENTIFIER
+                       ? lookup(token.getLexeme())
+                       : UNRESOLVED;
+        if (slot != UNRESOLVED &&
+            std::find(reads.begin(), reads.end(), slot) == reads.end()) {
+          reads.push_back(slot);
+        }
+      }
+      return {};
+    }
+
+    scopes.emplace_back();
+    blocks.push_back(stmt.get());
+    for (const std::shared_ptr<Stmt> &inner : stmt->getStatements()) {
+      resolve(inner);
+    }
+    blocks.pop_back();
+    scopes.pop_back();
+    return {};
+  }
+
+  std::any visitExpressionStmt(std::shared_ptr<Expression> stmt) override {
+    resolve(stmt->getExpression());
+    return {};
+  }
+
+  std::any visitPrintStmt(std::shared_ptr<Print> stmt) override {
+    resolve(stmt->getExpression());
+    return {};
+  }
+
+  std::any visitIfStmt(std::shared_ptr<If> stmt) override {
+    resolve(stmt->getCondition());
+    resolve(stmt->getThenBranch());
+    resolve(stmt->getElseBranch());
+    return {};
+  }
+
+  std::any visitWhileStmt(std::shared_ptr<While> stmt) override {
+    resolve(stmt->getCondition());
+    resolve(stmt->getBody());
+    return {};
+  }
+
+  std::any visitVarStmt(std::shared_ptr<Var> stmt) override {
+    // The initializer is resolved before the new variable is visible
+    if (stmt->getInitializer()) {
+      resolve(stmt->getInitializer());
+    }
+
+    std::map<std::string, int, std::less<>> &scope = scopes.back();
+    auto it = scope.find(stmt->getName().getLexeme());
+    if (it != scope.end()) {
+      // Re-declarations reuse the storage of the previous declaration
+      record(stmt.get(), it->second);
+      return {};
+    }
+
+    auto [declaration, inserted] = declarationSlots.try_emplace(
+        stmt.get(), static_cast<int>(globals.size()));
+    int slot = declaration->second;
+    if (inserted) {
+      globals.push_back(scopes.size() == 1);
+    }
+
+    scope.emplace(stmt->getName().getLexeme(), slot);
+    if (blocks.back()) {
+      std::vector<int> &local = blockSlots[blocks.back()];
+      if (std::find(local.begin(), local.end(), slot) == local.end()) {
+        local.push_back(slot);
+      }
+    }
+    record(stmt.get(), slot);
+    return {};
+  }
+};
+
+/** @internal
+ * @class LiveVariables
+ * @brief Backward analysis that computes the live slots at each point of the
+ * program and collects the last uses and dead stores.
+ *
+ * @note A node visited more than once (loops are iterated until a fixpoint,
+ * and nodes can be shared) is only marked if it's a last use or dead store in
+ * every visit.
+ * @note The live slots aren't copied for each branch: their changes are kept
+ * in a trail, undone at the end of a branch and only the changed slots are
+ * joined, so a branch costs as much as the variables used in it.
+ */
+class LiveVariables : public ExprVisitor, public StmtVisitor {
+private:
+  const SlotResolver &resolution;
+  const bool wholeProgram;
+  std::vector<bool> live;
+  std::vector<std::pair<int, bool>> trail;
+
+  void analyze(const std::shared_ptr<Expr> &expr) { expr->accept(*this); }
+
+  void analyze(const std::shared_ptr<Stmt> &stmt) {
+    if (stmt) {
+      stmt->accept(*this);
+    }
+  }
+
+  bool releasable(int slot) const {
+    return slot != UNRESOLVED && (wholeProgram || !resolution.globals[slot]);
+  }
+
+  template <class T>
+  static void mark(std::map<T *, bool> &marks, T *node, bool value) {
+    auto [it, inserted] = marks.try_emplace(node, value);
+    if (!inserted) {
+      it->second = it->second && value;
+    }
+  }
+
+  /** Changes a slot, recording its previous value in the trail. */
+  void set(int slot, bool value) {
+    if (live[slot] != value) {
+      trail.emplace_back(slot, live[slot]);
+      live[slot] = value;
+    }
+  }
+
+  /** Slots changed since the given size of the trail, with their value at
+   * that point.
+   */
+  std::map<int, bool> changedSince(std::size_t mark) const {
+    std::map<int, bool> changes;
+    for (std::size_t i = mark; i < trail.size(); i++) {
+      changes.try_emplace(trail[i].first, trail[i].second);
+    }
+    return changes;
+  }
+
+  void undo(std::size_t mark) {
+    while (trail.size() > mark) {
+      live[trail.back().first] = trail.back().second;
+      trail.pop_back();
+    }
+  }
+
+  /** Keeps one entry per slot changed since the given size of the trail, so
+   * the iterations of a loop don't make it grow.
+   */
+  void compact(std::size_t mark) {
+    std::map<int, bool> changes = changedSince(mark);
+    trail.resize(mark);
+    trail.insert(trail.end(), changes.begin(), changes.end());
+  }
+
+  /** Joins the current state with the one at the given size of the trail. */
+  void join(std::size_t mark) {
+    for (auto [slot, value] : changedSince(mark)) {
+      set(slot, live[slot] || value);
+    }
+  }
+
+  void kill(int slot) {
+    if (slot != UNRESOLVED) {
+      set(slot, false);
+    }
+  }
+
+  void kill(Block *block) {
+    auto it = resolution.blockSlots.find(block);
+    if (it != resolution.blockSlots.end()) {
+      for (int slot : it->second) {
+        set(slot, false);
+      }
+    }
+  }
+
+public:
+  std::map<Variable *, bool> lastUses;
+  std::map<Assign *, bool> assignDeadStores;
+  std::map<Var *, bool> varDeadStores;
+
+  LiveVariables(const SlotResolver &resolution, bool wholeProgram,
+                const std::vector<std::shared_ptr<Stmt>> &statements)
+      : resolution(resolution), wholeProgram(wholeProgram),
+        live(resolution.globals.size(), false) {
+    for (auto stmt = statements.rbegin(); stmt != statements.rend(); ++stmt) {
+      analyze(*stmt);
+      // No branch is open anymore, so these changes won't be undone
+      trail.clear();
+    }
+  }
+
+  std::any visitBinaryExpr(std::shared_ptr<Binary> expr) override {
+    analyze(expr->getRight());
+    analyze(expr->getLeft());
+    return {};
+  }
+
+  std::any visitLogicalExpr(std::shared_ptr<Logical> expr) override {
+    // The right operand may not be evaluated (short-circuit)
+    std::size_t after = trail.size();
+    analyze(expr->getRight());
+    join(after);
+    analyze(expr->getLeft());
+    return {};
+  }
+
+  std::any visitGroupingExpr(std::shared_ptr<Grouping> expr) override {
+    analyze(expr->getExpression());
+    return {};
+  }
+
+  std::any visitLiteralExpr(std::shared_ptr<Literal>) override { return {}; }
+
+  std::any visitUnaryExpr(std::shared_ptr<Unary> expr) override {
+    analyze(expr->getRight());
+    return {};
+  }
+
+  std::any visitAssignExpr(std::shared_ptr<Assign> expr) override {
+    int slot = resolution.slotOf(expr.get());
+    if (releasable(slot)) {
+      mark(assignDeadStores, expr.get(), !live[slot]);
+    }
+    kill(slot);
+    analyze(expr->getValue());
+    return {};
+  }
+
+  std::any visitVariableExpr(std::shared_ptr<Variable> expr) override {
+    int slot = resolution.slotOf(expr.get());
+    if (releasable(slot)) {
+      mark(lastUses, expr.get(), !live[slot]);
+    }
+    if (slot != UNRESOLVED) {
+      set(slot, true);
+    }
+    return {};
+  }
+
+  std::any visitBlockStmt(std::shared_ptr<Block> stmt) override {
+    if (stmt->isDeferred()) {
+      // Its writes may not happen, so they don't kill anything
+      auto it = resolution.deferredReads.find(stmt.get());
+      if (it != resolution.deferredReads.end()) {
+        for (int slot : it->second) {
+          set(slot, true);
+        }
+      }
+      return {};
+    }
+
+    // The variables declared in the block die when it ends
+    kill(stmt.get());
+    const std::vector<std::shared_ptr<Stmt>> &statements =
+        stmt->getStatements();
+    for (auto inner = statements.rbegin(); inner != statements.rend();
+         ++inner) {
+      analyze(*inner);
+    }
+    kill(stmt.get());
+    return {};
+  }
+
+  std::any visitExpressionStmt(std::shared_ptr<Expression> stmt) override {
+    analyze(stmt->getExpression());
+    return {};
+  }
+
+  std::any visitPrintStmt(std::shared_ptr<Print> stmt) override {
+    analyze(stmt->getExpression());
+    return {};
+  }
+
+  std::any visitIfStmt(std::shared_ptr<If> stmt) override {
+    std::size_t after = trail.size();
+    analyze(stmt->getThenBranch());
+    std::map<int, bool> thenLive = changedSince(after);
+    for (auto &[slot, value] : thenLive) {
+      value = live[slot];
+    }
+
+    undo(after);
+    analyze(stmt->getElseBranch());
+
+    // Only the slots changed by a branch can differ between both of them
+    std::map<int, bool> elseChanges = changedSince(after);
+    for (auto [slot, value] : thenLive) {
+      set(slot, live[slot] || value);
+    }
+    for (auto [slot, value] : elseChanges) {
+      if (!thenLive.count(slot)) {
+        set(slot, live[slot] || value);
+      }
+    }
+
+    analyze(stmt->getCondition());
+    return {};
+  }
+
+  std::any visitWhileStmt(std::shared_ptr<While> stmt) override {
+    std::size_t after = trail.size();
+    analyze(stmt->getCondition());
+
+    // Iterate until the live slots at the loop head don't change anymore
+    while (true) {
+      std::size_t head = trail.size();
+      analyze(stmt->getBody());
+      join(after);
+      analyze(stmt->getCondition());
+
+      std::map<int, bool> changes = changedSince(head);
+      if (std::all_of(changes.begin(), changes.end(), [this](auto change) {
+            return live[change.first] == change.second;
+          })) {
+        break;
+      }
+      compact(after);
+    }
+    return {};
+  }
+
+  std::any visitVarStmt(std::shared_ptr<Var> stmt) override {
+    int slot = resolution.slotOf(stmt.get());
+    if (releasable(slot)) {
+      mark(varDeadStores, stmt.get(), !live[slot]);
+    }
+    kill(slot);
+    if (stmt->getInitializer()) {
+      analyze(stmt->getInitializer());
+    }
+    return {};
+  }
+};
+
+} // namespace
+
+Liveness::Liveness(bool wholeProgram) : wholeProgram(wholeProgram) {}
+
+void Liveness::analyze(const std::vector<std::shared_ptr<Stmt>> &statements) {
+  SlotResolver resolution{statements};
+  LiveVariables liveVariables{resolution, wholeProgram, statements};
+
+  lastUses = 0;
+  for (auto &[variable, last] : liveVariables.lastUses) {
+    variable->setLastUse(last);
+    lastUses += last;
+  }
+
+  deadStores = 0;
+  for (auto &[assign, dead] : liveVariables.assignDeadStores) {
+    assign->setDeadStore(dead);
+    deadStores += dead;
+  }
+  for (auto &[var, dead] : liveVariables.varDeadStores) {
+    var->setDeadStore(dead);
+    deadStores += dead;
+  }
+}
+
+int Liveness::getLastUses() const { return lastUses; }
+
+int Liveness::getDeadStores() const { return deadStores; }
@@ -0,0 +1,385 @@
+#include "gsc/loopUnroller.hpp"
+#include <climits>
+#include <optional>
+#include <span>
+
+namespace {
+
+/** @internal
+ * @class LoopBodyScanner
+ * @brief Measures a loop body and checks if it writes the induction variable.
+ */
+class LoopBodyScanner : public ExprVisitor, public StmtVisitor {
+private:
+  const std::string &induction;
+
+  void scan(const std::shared_ptr<Expr> &expr) {
+    size++;
+    expr->accept(*this);
+  }
+
+  void scan(const std::shared_ptr<Stmt> &stmt) {
+    if (stmt) {
+      size++;
+      stmt->accept(*this);
+    }
+  }
+
+public:
+  int size = 0;
+  bool writesInduction = false;
+
+  LoopBodyScanner(const std::string &induction,
+                  const std::vector<std::shared_ptr<Stmt>> &statements)
+      : induction(induction) {
+    for (const std::shared_ptr<Stmt> &stmt : statements) {
+      scan(stmt);
+    }
+  }
+
+  std::any visitBinaryExpr(std::shared_ptr<Binary> expr) override {
+    scan(expr->getLeft());
+    scan(expr->getRight());
+    return {};
+  }
+
+  std::any visitLogicalExpr(std::shared_ptr<Logical> expr) override {
+    scan(expr->getLeft());
+    scan(expr->getRight());
+    return {};
+  }
+
+  std::any visitGroupingExpr(std::shared_ptr<Grouping> expr) override {
+    scan(expr->getExpression());
+    return {};
+  }
+
+  std::any visitLiteralExpr(std::shared_ptr<Literal>) override { return {}; }
+
+  std::any visitUnaryExpr(std::shared_ptr<Unary> expr) override {
+    scan(expr->getRight());
+    return {};
+  }
+
+  std::any visitAssignExpr(std::shared_ptr<Assign> expr) override {
+    writesInduction |= expr->getName().getLexeme() == induction;
+    scan(expr->getValue());
+    return {};
+  }
+
+  std::any visitVariableExpr(std::shared_ptr<Variable>) override { return {}; }
+
+  std::any visitBlockStmt(std::shared_ptr<Block> stmt) override {
+    if (stmt->isDeferred()) {
+      // Without its statements, count its tokens and look for assignments
+      std::span<const Token> tokens = stmt->getTokens();
+      size += static_cast<int>(tokens.size());
+      for (std::size_t i = 0; i + 1 < tokens.size(); i++) {
+        writesInduction |= tokens[i].getLexeme() == induction &&
+                           tokens[i].getType() == TokenType::IDENTIFIER &&
+                           tokens[i + 1].getType() == TokenType::EQUAL;
+      }
+      return {};
+    }
+
+    for (const std::shared_ptr<Stmt> &inner : stmt->getStatements()) {
+      scan(inner);
+    }
+    return {};
+  }
+
+  std::any visitExpressionStmt(std::shared_ptr<Expression> stmt) override {
+    scan(stmt->getExpression());
+    return {};
+  }
+
+  std::any visitPrintStmt(std::shared_ptr<Print> stmt) override {
+    scan(stmt->getExpression());
+    return {};
+  }
+
+  std::any visitIfStmt(std::shared_ptr<If> stmt) override {
+    scan(stmt->getCondition());
+    scan(stmt->getThenBranch());
+    scan(stmt->getElseBranch());
+    return {};
+  }
+
+  std::any visitWhileStmt(std::shared_ptr<While> stmt) override {
+    scan(stmt->getCondition());
+    scan(stmt->getBody());
+    return {};
+  }
+
+  std::any visitVarStmt(std::shared_ptr<Var> stmt) override {
+    // A shadowing declaration is conservatively treated as a write
+    writesInduction |= stmt->getName().getLexeme() == induction;
+    if (stmt->getInitializer()) {
+      scan(stmt->getInitializer());
+    }
+    return {};
+  }
+};
+
+std::optional<long long> intLiteral(const std::shared_ptr<Expr> &expr) {
+  if (std::shared_ptr<Literal> literal =
+          std::dynamic_pointer_cast<Literal>(expr)) {
+    if (literal->getValue().type() == typeid(int)) {
+      return std::any_cast<int>(literal->getValue());
+    }
+  } else if (std::shared_ptr<Unary> unary =
+                 std::dynamic_pointer_cast<Unary>(expr)) {
+    std::optional<long long> value = intLiteral(unary->getRight());
+    if (value && unary->getOp().getType() == TokenType::MINUS) {
+      return -*value;
+    }
+  }
+  return std::nullopt;
+}
+
+bool isVariable(const std::shared_ptr<Expr> &expr, const std::string &name) {
+  std::shared_ptr<Variable> variable =
+      std::dynamic_pointer_cast<Variable>(expr);
+  return variable && variable->getName().getLexeme() == name;
+}
+
+/** @internal
+ * @brief Computes how many times a loop `for (i = start; i OP bound; i +=
+ * step)` runs.
+ *
+ * @return The trip count, or nothing if the loop doesn't terminate or the
+ * induction variable overflows.
+ */
+std::optional<long long> tripCount(long long start, TokenType op,
+                                   long long bound, long long step) {
+  long long trips;
+  switch (op) {
+  case TokenType::LESS:
+    if (start >= bound)
+      return 0;
+    if (step <= 0)
+      return std::nullopt;
+    trips = (bound - start + step - 1) / step;
+    break;
+  case TokenType::LESS_EQUAL:
+    if (start > bound)
+      return 0;
+    if (step <= 0)
+      return std::nullopt;
+    trips = (bound - start) / step + 1;
+    break;
+  case TokenType::GREATER:
+    if (start <= bound)
+      return 0;
+    if (step >= 0)
+      return std::nullopt;
+    trips = (start - bound - step - 1) / -step;
+    break;
+  case TokenType::GREATER_EQUAL:
+    if (start < bound)
+      return 0;
+    if (step >= 0)
+      return std::nullopt;
+    trips = (start - bound) / -step + 1;
+    break;
+  default:
+    return std::nullopt;
+  }
+
+  long long last = start + trips * step;
+  if (last < INT_MIN || last > INT_MAX) {
+    return std::nullopt;
+  }
+  return trips;
+}
+
+} // namespace
+
+LoopUnroller::LoopUnroller(int factor, int budget)
+    : factor(factor < 1 ? 1 : factor), budget(budget) {}
+
+std::vector<std::shared_ptr<Stmt>>
+LoopUnroller::unroll(const std::vector<std::shared_ptr<Stmt>> &statements) {
+  return transform(statements);
+}
+
+int LoopUnroller::getUnrolledLoops() const { return unrolledLoops; }
+
+std::shared_ptr<Stmt> LoopUnroller::transform(std::shared_ptr<Stmt> stmt) {
+  if (!stmt) {
+    return stmt;
+  }
+  return std::any_cast<std::shared_ptr<Stmt>>(stmt->accept(*this));
+}
+
+std::vector<std::shared_ptr<Stmt>> LoopUnroller::transform(
+    const std::vector<std::shared_ptr<Stmt>> &statements) {
+  std::vector<std::shared_ptr<Stmt>> transformed;
+  transformed.reserve(statements.size());
+  for (const std::shared_ptr<Stmt> &stmt : statements) {
+    transformed.push_back(transform(stmt));
+  }
+
+  std::vector<std::shared_ptr<Stmt>> result;
+  result.reserve(transformed.size());
+
+  for (std::size_t i = 0; i < transformed.size(); i++) {
+    result.push_back(transformed[i]);
+
+    std::shared_ptr<Var> init =
+        std::dynamic_pointer_cast<Var>(transformed[i]);
+    std::shared_ptr<While> loop =
+        i + 1 < transformed.size()
+            ? std::dynamic_pointer_cast<While>(transformed[i + 1])
+            : nullptr;
+    if (!init || !loop) {
+      continue;
+    }
+
+    std::vector<std::shared_ptr<Stmt>> unrolled = unroll(init, loop);
+    if (!unrolled.empty()) {
+      result.insert(result.end(), unrolled.begin(), unrolled.end());
+      i++;
+    }
+  }
+
+  return result;
+}
+
+std::vector<std::shared_ptr<Stmt>>
+LoopUnroller::unroll(const std::shared_ptr<Var> &init,
+                     const std::shared_ptr<While> &loop) {
+  const std::string name{init->getName().getLexeme()};
+  std::optional<long long> start =
+      init->getInitializer() ? intLiteral(init->getInitializer())
+                             : std::nullopt;
+
+  std::shared_ptr<Binary> condition =
+      std::dynamic_pointer_cast<Binary>(loop->getCondition());
+  std::shared_ptr<Block> body =
+      std::dynamic_pointer_cast<Block>(loop->getBody());
+  if (!start || !condition || !isVariable(condition->getLeft(), name) ||
+      !body || body->isDeferred() || body->getStatements().empty()) {
+    return {};
+  }
+  std::optional<long long> bound = intLiteral(condition->getRight());
+
+  // The last statement of the body must be the increment
+  std::vector<std::shared_ptr<Stmt>> statements = body->getStatements();
+  std::shared_ptr<Expression> increment =
+      std::dynamic_pointer_cast<Expression>(statements.back());
+  std::shared_ptr<Assign> assign =
+      increment ? std::dynamic_pointer_cast<Assign>(increment->getExpression())
+                : nullptr;
+  if (!bound || !assign || assign->getName().getLexeme() != name) {
+    return {};
+  }
+
+  std::shared_ptr<Binary> next =
+      std::dynamic_pointer_cast<Binary>(assign->getValue());
+  std::optional<long long> step =
+      next ? intLiteral(next->getRight()) : std::nullopt;
+  if (!step || !isVariable(next->getLeft(), name) ||
+      (next->getOp().getType() != TokenType::PLUS &&
+       next->getOp().getType() != TokenType::MINUS)) {
+    return {};
+  }
+  if (next->getOp().getType() == TokenType::MINUS) {
+    step = -*step;
+  }
+
+  statements.pop_back();
+  LoopBodyScanner scanner{name, statements};
+  std::optional<long long> trips =
+      tripCount(*start, condition->getOp().getType(), *bound, *step);
+  if (scanner.writesInduction || !trips || *trips == 0) {
+    return {};
+  }
+
+  // Fully unroll short loops, otherwise keep a loop with `factor` copies
+  long long prologue = *trips <= factor ? *trips : *trips % factor;
+  long long copiesPerIteration = *trips <= factor ? 0 : factor;
+
+  // Each copy of the body costs its statements, plus the increment
+  // (an expression statement, an assignment, a binary, a variable and a
+  // literal)
+  long long iterationSize = scanner.size + 5;
+  long long growth = (prologue + copiesPerIteration - 1) * iterationSize;
+  if (growth > budget) {
+    return {};
+  }
+  budget -= static_cast<int>(growth > 0 ? growth : 0);
+  unrolledLoops++;
+
+  // Declarations of the body must stay in their own scope
+  statements.push_back(increment);
+  std::vector<std::shared_ptr<Stmt>> iteration = statements;
+  for (const std::shared_ptr<Stmt> &stmt : statements) {
+    if (std::dynamic_pointer_cast<Var>(stmt)) {
+      iteration = {std::make_shared<Block>(statements)};
+      break;
+    }
+  }
+
+  std::vector<std::shared_ptr<Stmt>> result;
+  for (long long i = 0; i < prologue; i++) {
+    result.insert(result.end(), iteration.begin(), iteration.end());
+  }
+
+  if (copiesPerIteration > 0) {
+    std::vector<std::shared_ptr<Stmt>> unrolledBody;
+    for (long long i = 0; i < copiesPerIteration; i++) {
+      unrolledBody.insert(unrolledBody.end(), iteration.begin(),
+                          iteration.end());
+    }
+    result.push_back(std::make_shared<While>(
+        condition, std::make_shared<Block>(std::move(unrolledBody))));
+  }
+
+  return result;
+}
+
+std::any LoopUnroller::visitBlockStmt(std::shared_ptr<Block> stmt) {
+  // The loops of a deferred block are parsed when it runs, after the passes
+  if (stmt->isDeferred()) {
+    return std::shared_ptr<Stmt>(stmt);
+  }
+  std::vector<std::shared_ptr<Stmt>> statements =
+      transform(stmt->getStatements());
+  if (statements == stmt->getStatements()) {
+    return std::shared_ptr<Stmt>(stmt);
+  }
+  return std::shared_ptr<Stmt>(std::make_shared<Block>(std::move(statements)));
+}
+
+std::any LoopUnroller::visitExpressionStmt(std::shared_ptr<Expression> stmt) {
+  return std::shared_ptr<Stmt>(stmt);
+}
+
+std::any LoopUnroller::visitPrintStmt(std::shared_ptr<Print> stmt) {
+  return std::shared_ptr<Stmt>(stmt);
+}
+
+std::any LoopUnroller::visitIfStmt(std::shared_ptr<If> stmt) {
+  std::shared_ptr<Stmt> thenBranch = transform(stmt->getThenBranch());
+  std::shared_ptr<Stmt> elseBranch = transform(stmt->getElseBranch());
+  if (thenBranch == stmt->getThenBranch() &&
+      elseBranch == stmt->getElseBranch()) {
+    return std::shared_ptr<Stmt>(stmt);
+  }
+  return std::shared_ptr<Stmt>(
+      std::make_shared<If>(stmt->getCondition(), thenBranch, elseBranch));
+}
+
+std::any LoopUnroller::visitWhileStmt(std::shared_ptr<While> stmt) {
+  std::shared_ptr<Stmt> body = transform(stmt->getBody());
+  if (body == stmt->getBody()) {
+    return std::shared_ptr<Stmt>(stmt);
+  }
+  return std::shared_ptr<Stmt>(
+      std::make_shared<While>(stmt->getCondition(), body));
+}
+
+std::any LoopUnroller::visitVarStmt(std::shared_ptr<Var> stmt) {
+  return std::shared_ptr<Stmt>(stmt);
+}
@@ -0,0 +1,91 @@
+#include "gsc/optimizer.hpp"
+#include "gsc/liveness.hpp"
+#include "gsc/loopUnroller.hpp"
+#include "gsc/typeInference.hpp"
+#include <chrono>
+
+namespace {
+
+class TypeInferencePass : public Pass {
+public:
+  std::string getName() const override { return "type-inference"; }
+
+  std::vector<std::shared_ptr<Stmt>>
+  run(const std::vector<std::shared_ptr<Stmt>> &statements) override {
+    TypeInference().analyze(statements);
+    return statements;
+  }
+};
+
+class LoopUnrollingPass : public Pass {
+public:
+  std::string getName() const override { return "loop-unrolling"; }
+
+  std::vector<std::shared_ptr<Stmt>>
+  run(const std::vector<std::shared_ptr<Stmt>> &statements) override {
+    return LoopUnroller().unroll(statements);
+  }
+};
+
+class LivenessPass : public Pass {
+private:
+  const bool wholeProgram;
+
+public:
+  LivenessPass(bool wholeProgram) : wholeProgram(wholeProgram) {}
+
+  std::string getName() const override { return "liveness"; }
+
+  std::vector<std::shared_ptr<Stmt>>
+  run(const std::vector<std::shared_ptr<Stmt>> &statements) override {
+    Liveness(wholeProgram).analyze(statements);
+    return statements;
+  }
+};
+
+} // namespace
+
+Optimizer::Optimizer(OptimizationLevel level, bool wholeProgram) {
+  // The unrolled copies must be annotated too, so the transformations go
+  // before the analyses
+  if (level >= OptimizationLevel::O2) {
+    addPass(std::make_unique<LoopUnrollingPass>());
+  }
+  if (level >= OptimizationLevel::O1) {
+    addPass(std::make_unique<TypeInferencePass>());
+    addPass(std::make_unique<LivenessPass>(wholeProgram));
+  }
+}
+
+void Optimizer::addPass(std::unique_ptr<Pass> pass) {
+  passes.push_back(std::move(pass));
+}
+
+void Optimizer::setTimingOutput(std::ostream *out) { timingOutput = out; }
+
+std::vector<std::string> Optimizer::getPassNames() const {
+  std::vector<std::string> names;
+  for (const std::unique_ptr<Pass> &pass : passes) {
+    names.push_back(pass->getName());
+  }
+  return names;
+}
+
+std::vector<std::shared_ptr<Stmt>>
+Optimizer::optimize(const std::vector<std::shared_ptr<Stmt>> &statements) {
+  std::vector<std::shared_ptr<Stmt>> result = statements;
+
+  for (const std::unique_ptr<Pass> &pass : passes) {
+    auto start = std::chrono::steady_clock::now();
+    result = pass->run(result);
+    auto end = std::chrono::steady_clock::now();
+
+    if (timingOutput) {
+      std::chrono::duration<double, std::milli> elapsed = end - start;
+      *timingOutput << "[pass] " << pass->getName() << ": " << elapsed.count()
+                    << " ms\n";
+    }
+  }
+
+  return result;
+}
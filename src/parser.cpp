@@ -1,30 +1,292 @@
 #include "gsc/parser.hpp"
 #include "gsc/error.hpp"
+#include "gsc/hash.hpp"
+#include <algorithm>
+#include <array>
 #include <cassert>
-
-Parser::Parser(const std::vector<Token> &tokens) : tokens(tokens) {}
+#include <iterator>
+#include <limits>
+#include <thread>
+
+namespace {
+
+/** @internal
+ * @struct InfixRule
+ * @brief How a token is parsed between two operands.
+ *
+ * @note The precedence goes from `or` (the lowest) to `*` and `/`, and 0
+ * means the token isn't an operator, which ends the expression.
+ */
+struct InfixRule {
+  int precedence = 0;
+  bool logical = false;
+};
+
+constexpr int LOWEST_PRECEDENCE = 1;
+
+constexpr std::array<InfixRule, END_OF_FILE + 1> infixRules = [] {
+  std::array<InfixRule, END_OF_FILE + 1> rules{};
+  rules[OR] = {1, true};
+  rules[AND] = {2, true};
+  rules[BANG_EQUAL] = rules[EQUAL_EQUAL] = {3, false};
+  rules[GREATER] = rules[GREATER_EQUAL] = {4, false};
+  rules[LESS] = rules[LESS_EQUAL] = {4, false};
+  rules[MINUS] = rules[PLUS] = {5, false};
+  rules[SLASH] = rules[STAR] = {6, false};
+  return rules;
+}();
+
+} // namespace
+
+Parser::Parser(std::span<const Token> tokens) : tokens(tokens) {}
+
+Parser::Parser(Scanner &scanner) : scanner(&scanner) {
+  window.push_back(scanner.next());
+}
 
 std::vector<std::shared_ptr<Stmt>> Parser::parse() {
+  // Pulling the tokens would interleave the errors of the Scanner with ours,
+  // so ours wait until the whole source is scanned, as if it was scanned
+  // first
+  DiagnosticList pulled{diagnosticSink
+                            ? diagnosticSink->getLimit()
+                            : std::numeric_limits<std::size_t>::max()};
+  if (scanner && !diagnostics) {
+    diagnostics = &pulled;
+  }
+
   std::vector<std::shared_ptr<Stmt>> statements;
-  while (!isAtEnd()) {
+  while (!isAtEnd() && !aborted) {
     statements.push_back(declaration());
   }
 
+  if (diagnostics == &pulled) {
+    while (!isAtEnd()) {
+      advance();
+    }
+    diagnostics = nullptr;
+    report(pulled);
+  }
+  return statements;
+}
+
+std::vector<std::shared_ptr<Stmt>> Parser::parse(unsigned threads,
+                                                 std::size_t chunkSize) {
+  const std::size_t chunks =
+      scanner ? 1
+              : std::min<std::size_t>(std::max(threads, 1u),
+                                      (tokens.size() - current) /
+                                          std::max<std::size_t>(chunkSize, 1));
+  std::vector<std::size_t> splits =
+      chunks > 1 ? findSplits(chunks) : std::vector<std::size_t>{};
+  if (splits.size() <= 1) {
+    return parse();
+  }
+
+  // The last chunk ends before the END_OF_FILE token
+  splits.push_back(tokens.size() - 1);
+  const std::size_t limit = diagnosticSink
+                                ? diagnosticSink->getLimit()
+                                : std::numeric_limits<std::size_t>::max();
+  std::vector<DiagnosticList> errors(splits.size() - 1, DiagnosticList{limit});
+  std::vector<Parser> parsers;
+  parsers.reserve(splits.size() - 1);
+  for (std::size_t i = 0; i + 1 < splits.size(); i++) {
+    Parser &chunk = parsers.emplace_back(
+        tokens.subspan(splits[i], splits[i + 1] - splits[i]));
+    const Token &next = tokens[splits[i + 1]];
+    chunk.endOfChunk.emplace(END_OF_FILE, next.getLexeme().substr(0, 0),
+                             nullptr, next.getLine());
+    chunk.maxDepth = maxDepth;
+    chunk.lazyBlocks = lazyBlocks;
+    chunk.diagnostics = &errors[i];
+  }
+
+  // The first chunk is parsed by this thread
+  std::vector<std::vector<std::shared_ptr<Stmt>>> results(parsers.size());
+  std::vector<std::thread> workers;
+  for (std::size_t i = 1; i < parsers.size(); i++) {
+    workers.emplace_back([&chunk = parsers[i], &result = results[i]] {
+      result = chunk.parse();
+    });
+  }
+  results[0] = parsers[0].parse();
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+
+  std::vector<std::shared_ptr<Stmt>> statements;
+  for (std::size_t i = 0; i < parsers.size(); i++) {
+    report(errors[i]);
+    statements.insert(statements.end(),
+                      std::make_move_iterator(results[i].begin()),
+                      std::make_move_iterator(results[i].end()));
+    // Stop where a single thread would have stopped
+    if (parsers[i].aborted) {
+      aborted = true;
+      break;
+    }
+  }
+
+  current = static_cast<int>(tokens.size()) - 1;
   return statements;
 }
 
+ParsedProgram Parser::parseProgram() {
+  assert(!scanner);
+  ParsedProgram program;
+  while (!isAtEnd() && !aborted) {
+    parseStatement(program);
+  }
+
+  program.end = tokens.size() - 1;
+  return program;
+}
+
+ParsedProgram Parser::reparse(const ParsedProgram &previous) {
+  assert(!scanner);
+  ParsedProgram program;
+  const std::vector<StatementSpan> &spans = previous.spans;
+  const std::size_t end = tokens.size() - 1;
+
+  // The statements before the edit are at the same tokens
+  std::size_t first = 0;
+  while (first < spans.size() && reuse(program, previous, first, current)) {
+    first++;
+  }
+
+  // The statements after the edit are at the same distance from the end
+  std::size_t last = spans.size();
+  std::size_t suffix = end;
+  if (!spans.empty() && spans.back().end == previous.end) {
+    while (last > first) {
+      const StatementSpan &span = spans[last - 1];
+      std::size_t size = span.end - span.begin;
+      if (size > suffix - current || !previous.statements[last - 1] ||
+          hashTokens(suffix - size, suffix) != span.hash ||
+          tokens[suffix].getType() == TokenType::ELSE) {
+        break;
+      }
+      suffix -= size;
+      last--;
+    }
+  }
+
+  // Parse the edited statements, until one ends where a statement after the
+  // edit starts
+  auto newBegin = [&](std::size_t index) {
+    return spans[index].begin + end - previous.end;
+  };
+  while (true) {
+    // Skip the statements that the edited ones took
+    while (last < spans.size() && newBegin(last) < std::size_t(current)) {
+      last++;
+    }
+    if (isAtEnd() || aborted ||
+        (last < spans.size() && newBegin(last) == std::size_t(current))) {
+      break;
+    }
+    parseStatement(program);
+  }
+
+  if (!aborted) {
+    // They were already compared with their tokens
+    for (; last < spans.size(); last++) {
+      const StatementSpan &span = spans[last];
+      const std::size_t begin = newBegin(last);
+      program.statements.push_back(previous.statements[last]);
+      program.spans.push_back(
+          {begin, begin + span.end - span.begin, span.hash});
+    }
+    current = static_cast<int>(end);
+  }
+  program.end = end;
+  return program;
+}
+
+void Parser::parseStatement(ParsedProgram &program) {
+  std::size_t begin = current;
+  program.statements.push_back(declaration());
+  program.spans.push_back({begin, std::size_t(current),
+                           hashTokens(begin, current)});
+}
+
+bool Parser::reuse(ParsedProgram &program, const ParsedProgram &previous,
+                   std::size_t index, std::size_t position) {
+  const StatementSpan &span = previous.spans[index];
+  const std::size_t size = span.end - span.begin;
+  const std::size_t end = position + size;
+  if (!previous.statements[index] || end >= tokens.size() ||
+      tokens[end].getType() == TokenType::ELSE ||
+      hashTokens(position, end) != span.hash) {
+    return false;
+  }
+
+  program.statements.push_back(previous.statements[index]);
+  program.spans.push_back({position, end, span.hash});
+  current = static_cast<int>(end);
+  return true;
+}
+
+std::uint64_t Parser::hashTokens(std::size_t begin, std::size_t end) const {
+  std::uint64_t hash = FNV_OFFSET_BASIS;
+  for (std::size_t i = begin; i < end; i++) {
+    const Token &token = tokens[i];
+    const std::uint32_t fields[] = {
+        static_cast<std::uint32_t>(token.getType()),
+        static_cast<std::uint32_t>(token.getLine()),
+        static_cast<std::uint32_t>(token.getLexeme().size())};
+    hash = hashBytes({reinterpret_cast<const char *>(fields), sizeof(fields)},
+                     hash);
+    hash = hashBytes(token.getLexeme(), hash);
+  }
+  return hash;
+}
+
+std::vector<std::size_t> Parser::findSplits(std::size_t chunks) const {
+  std::vector<std::size_t> splits{static_cast<std::size_t>(current)};
+  const std::size_t size = tokens.size() - current;
+  int nesting = 0;
+
+  for (std::size_t i = current; i + 1 < tokens.size() && splits.size() < chunks;
+       i++) {
+    TokenType type = tokens[i].getType();
+    if (type == LEFT_PAREN || type == LEFT_BRACE) {
+      nesting++;
+    } else if (type == RIGHT_PAREN || type == RIGHT_BRACE) {
+      nesting--;
+    }
+
+    TokenType next = tokens[i + 1].getType();
+    if ((type == SEMICOLON || type == RIGHT_BRACE) && nesting == 0 &&
+        next != ELSE && next != END_OF_FILE &&
+        i + 1 - current >= splits.size() * size / chunks) {
+      splits.push_back(i + 1);
+    }
+  }
+  return splits;
+}
+
 std::shared_ptr<Stmt> Parser::declaration() {
-  try {
-    if (match(TokenType::VAR))
-      return varDeclaration();
-    return statement();
-  } catch (ParseError &error) {
-    synchronize();
+  std::shared_ptr<Stmt> stmt =
+      match(TokenType::VAR) ? varDeclaration() : statement();
+
+  if (panicking) {
+    // Skip the rest of the statement (unless the whole parse stopped)
+    if (!aborted) {
+      synchronize();
+      panicking = false;
+    }
     return nullptr; // Return null on error
   }
+  return stmt;
 }
 
 std::shared_ptr<Stmt> Parser::statement() {
+  DepthScope scope{*this};
+  if (!nest(peek(), "Statement is nested too deeply."))
+    return nullptr;
+
   if (match(TokenType::PRINT))
     return printStatement();
   else if (match(TokenType::IF))
@@ -33,56 +295,84 @@ std::shared_ptr<Stmt> Parser::statement() {
     return whileStatement();
   else if (match(TokenType::FOR))
     return forStatement();
-  else if (match(TokenType::LEFT_BRACE))
-    return std::make_shared<Block>(block());
-  else
+  else if (match(TokenType::LEFT_BRACE)) {
+    if (lazyBlocks && !scanner) {
+      if (std::shared_ptr<Stmt> deferred = deferredBlock())
+        return deferred;
+    }
+    std::vector<std::shared_ptr<Stmt>> statements = block();
+    if (panicking)
+      return nullptr;
+    return std::make_shared<Block>(std::move(statements));
+  } else
     return expressionStatement();
 }
 
 std::shared_ptr<Stmt> Parser::printStatement() {
   std::shared_ptr<Expr> value = expression();
-  consume(TokenType::SEMICOLON, "Expect ';' after value.");
+  if (panicking || !consume(TokenType::SEMICOLON, "Expect ';' after value."))
+    return nullptr;
   return std::make_shared<Print>(value);
 }
 
 std::shared_ptr<Stmt> Parser::ifStatement() {
-  consume(TokenType::LEFT_PAREN, "Expect '(' after 'if'.");
+  if (!consume(TokenType::LEFT_PAREN, "Expect '(' after 'if'."))
+    return nullptr;
   std::shared_ptr<Expr> condition = expression();
-  consume(TokenType::RIGHT_PAREN, "Expect ')' after if condition.");
+  if (panicking ||
+      !consume(TokenType::RIGHT_PAREN, "Expect ')' after if condition."))
+    return nullptr;
 
   std::shared_ptr<Stmt> thenBranch = statement();
+  if (panicking)
+    return nullptr;
   std::shared_ptr<Stmt> elseBranch =
       match(TokenType::ELSE) ? statement() : nullptr;
+  if (panicking)
+    return nullptr;
 
   return std::make_shared<If>(condition, thenBranch, elseBranch);
 }
 
 std::shared_ptr<Stmt> Parser::whileStatement() {
-  consume(TokenType::LEFT_PAREN, "Expect '(' after 'while'.");
+  if (!consume(TokenType::LEFT_PAREN, "Expect '(' after 'while'."))
+    return nullptr;
   std::shared_ptr<Expr> condition = expression();
-  consume(TokenType::RIGHT_PAREN, "Expect ')' after while condition.");
+  if (panicking ||
+      !consume(TokenType::RIGHT_PAREN, "Expect ')' after while condition."))
+    return nullptr;
 
   std::shared_ptr<Stmt> body = statement();
+  if (panicking)
+    return nullptr;
   return std::make_shared<While>(condition, body);
 }
 
 std::shared_ptr<Stmt> Parser::forStatement() {
-  consume(TokenType::LEFT_PAREN, "Expect '(' after 'for'.");
+  if (!consume(TokenType::LEFT_PAREN, "Expect '(' after 'for'."))
+    return nullptr;
 
   std::shared_ptr<Stmt> initializer =
       match(TokenType::SEMICOLON)
           ? nullptr
           : (match(VAR) ? varDeclaration() : expressionStatement());
+  if (panicking)
+    return nullptr;
 
   std::shared_ptr<Expr> condition =
       check(TokenType::SEMICOLON) ? nullptr : expression();
-  consume(SEMICOLON, "Expect ';' after loop condition.");
+  if (panicking || !consume(SEMICOLON, "Expect ';' after loop condition."))
+    return nullptr;
 
   std::shared_ptr<Expr> increment =
       check(TokenType::RIGHT_PAREN) ? nullptr : expression();
-  consume(TokenType::RIGHT_PAREN, "Expect ')' after for parameters.");
+  if (panicking ||
+      !consume(TokenType::RIGHT_PAREN, "Expect ')' after for parameters."))
+    return nullptr;
 
   std::shared_ptr<Stmt> body = statement();
+  if (panicking)
+    return nullptr;
 
   // Desugaring for statement
   if (increment)
@@ -102,71 +392,110 @@ std::shared_ptr<Stmt> Parser::forStatement() {
 }
 
 std::shared_ptr<Stmt> Parser::varDeclaration() {
-  Token name = consume(TokenType::IDENTIFIER, "Expect variable name.");
+  const Token *name = consume(TokenType::IDENTIFIER, "Expect variable name.");
+  if (!name)
+    return nullptr;
+  Token nameToken = *name;
   std::shared_ptr<Expr> initializer = nullptr;
 
   if (match(TokenType::EQUAL)) {
     initializer = expression();
+    if (panicking)
+      return nullptr;
   }
 
-  consume(TokenType::SEMICOLON, "Expect ';' after variable declaration.");
-  return std::make_shared<Var>(std::move(name), initializer);
+  if (!consume(TokenType::SEMICOLON, "Expect ';' after variable declaration."))
+    return nullptr;
+  return std::make_shared<Var>(std::move(nameToken), initializer);
 }
 
 std::shared_ptr<Stmt> Parser::expressionStatement() {
   std::shared_ptr<Expr> expr = expression();
-  consume(TokenType::SEMICOLON, "Expect ';' after expression.");
+  if (panicking ||
+      !consume(TokenType::SEMICOLON, "Expect ';' after expression."))
+    return nullptr;
   return std::make_shared<Expression>(expr);
 }
 
 std::vector<std::shared_ptr<Stmt>> Parser::block() {
   std::vector<std::shared_ptr<Stmt>> statements;
 
-  while (!isAtEnd() && !check(TokenType::RIGHT_BRACE)) {
+  while (!isAtEnd() && !check(TokenType::RIGHT_BRACE) && !aborted) {
     statements.push_back(declaration());
   }
 
-  consume(TokenType::RIGHT_BRACE, "Expect '}' after block.");
+  if (aborted || !consume(TokenType::RIGHT_BRACE, "Expect '}' after block."))
+    return {};
+  return statements;
+}
+
+std::shared_ptr<Stmt> Parser::deferredBlock() {
+  // The '{' was already matched
+  const std::size_t begin = current - 1;
+  int nesting = 0;
+  for (std::size_t i = current; i < tokens.size(); i++) {
+    TokenType type = tokens[i].getType();
+    if (type == LEFT_BRACE) {
+      nesting++;
+    } else if (type == RIGHT_BRACE && nesting-- == 0) {
+      current = static_cast<int>(i) + 1;
+      return std::make_shared<Block>(
+          tokens.subspan(begin, i + 1 - begin),
+          [depth = depth, maxDepth = maxDepth](std::span<const Token> body) {
+            return parseDeferred(body, depth, maxDepth);
+          });
+    } else if (type == END_OF_FILE) {
+      break;
+    }
+  }
+  return nullptr;
+}
+
+std::vector<std::shared_ptr<Stmt>>
+Parser::parseDeferred(std::span<const Token> tokens, int depth,
+                      int maxDepth) {
+  Parser parser{tokens};
+  const Token &close = tokens.back();
+  parser.endOfChunk.emplace(END_OF_FILE, close.getLexeme().substr(1),
+                            nullptr, close.getLine());
+  parser.depth = depth;
+  parser.maxDepth = maxDepth;
+  parser.lazyBlocks = true;
+  DiagnosticList errors;
+  parser.diagnostics = &errors;
+
+  // The body is parsed as if the block was parsed eagerly
+  parser.current = 1;
+  std::vector<std::shared_ptr<Stmt>> statements = parser.block();
+  if (!errors.getDiagnostics().empty() || errors.getDropped() > 0) {
+    report(errors);
+    throw RuntimeError(std::make_shared<Token>(tokens.front()),
+                       "Syntax error in block.");
+  }
   return statements;
 }
 
 std::shared_ptr<Expr> Parser::assignment() {
-  std::shared_ptr<Expr> expr = orLogical();
+  DepthScope scope{*this};
+  std::shared_ptr<Expr> expr = binary(LOWEST_PRECEDENCE);
+  if (panicking)
+    return nullptr;
 
   if (match(TokenType::EQUAL)) {
     Token equals = previous();
+    if (!nest(equals, "Expression is nested too deeply."))
+      return nullptr;
     std::shared_ptr<Expr> value = assignment();
+    if (panicking)
+      return nullptr;
 
     if (std::shared_ptr<Variable> var =
             std::dynamic_pointer_cast<Variable>(expr)) {
       return std::make_shared<Assign>(var->getName(), value);
     }
 
-    throw error(equals, "Invalid assignment target.");
-  }
-
-  return expr;
-}
-
-std::shared_ptr<Expr> Parser::orLogical() {
-  std::shared_ptr<Expr> expr = andLogical();
-
-  while (match(TokenType::OR)) {
-    Token operatorToken = previous();
-    std::shared_ptr<Expr> right = andLogical();
-    expr = std::make_shared<Logical>(expr, std::move(operatorToken), right);
-  }
-
-  return expr;
-}
-
-std::shared_ptr<Expr> Parser::andLogical() {
-  std::shared_ptr<Expr> expr = equality();
-
-  while (match(TokenType::AND)) {
-    Token operatorToken = previous();
-    std::shared_ptr<Expr> right = equality();
-    expr = std::make_shared<Logical>(expr, std::move(operatorToken), right);
+    error(equals, "Invalid assignment target.");
+    return nullptr;
   }
 
   return expr;
@@ -174,131 +503,156 @@ std::shared_ptr<Expr> Parser::andLogical() {
 
 std::shared_ptr<Expr> Parser::expression() { return assignment(); }
 
-std::shared_ptr<Expr> Parser::equality() {
-  std::shared_ptr<Expr> expr = comparison();
-
-  while (match(TokenType::BANG_EQUAL, TokenType::EQUAL_EQUAL)) {
-    Token operatorToken = previous();
-    std::shared_ptr<Expr> right = comparison();
-    expr = std::make_shared<Binary>(expr, std::move(operatorToken), right);
-  }
-
-  return expr;
-}
-
-std::shared_ptr<Expr> Parser::comparison() {
-  std::shared_ptr<Expr> expr = term();
-
-  while (match(TokenType::GREATER, TokenType::GREATER_EQUAL, TokenType::LESS,
-               TokenType::LESS_EQUAL)) {
-    Token operatorToken = previous();
-    std::shared_ptr<Expr> right = term();
-    expr = std::make_shared<Binary>(expr, std::move(operatorToken), right);
-  }
-
-  return expr;
-}
-
-std::shared_ptr<Expr> Parser::term() {
-  std::shared_ptr<Expr> expr = factor();
-
-  while (match(TokenType::MINUS, TokenType::PLUS)) {
-    Token operatorToken = previous();
-    std::shared_ptr<Expr> right = factor();
-    expr = std::make_shared<Binary>(expr, std::move(operatorToken), right);
-  }
+std::shared_ptr<Expr> Parser::binary(int precedence) {
+  DepthScope scope{*this};
+  std::shared_ptr<Expr> expr = prefix();
+  if (panicking)
+    return nullptr;
 
-  return expr;
-}
-
-std::shared_ptr<Expr> Parser::factor() {
-  std::shared_ptr<Expr> expr = unary();
+  int operators = 0;
+  while (true) {
+    const InfixRule &rule = infixRules[peek().getType()];
+    if (rule.precedence < precedence) {
+      break;
+    }
 
-  while (match(TokenType::SLASH, TokenType::STAR)) {
-    Token operatorToken = previous();
-    std::shared_ptr<Expr> right = unary();
-    expr = std::make_shared<Binary>(expr, std::move(operatorToken), right);
+    Token operatorToken = advance();
+    // Each operator makes the AST (but not this loop) one level deeper
+    if (++operators % OPERATORS_PER_LEVEL == 0 &&
+        !nest(operatorToken, "Expression is nested too deeply."))
+      return nullptr;
+    // All the operators are left-associative
+    std::shared_ptr<Expr> right = binary(rule.precedence + 1);
+    if (panicking)
+      return nullptr;
+    if (rule.logical) {
+      expr = std::make_shared<Logical>(expr, std::move(operatorToken), right);
+    } else {
+      expr = std::make_shared<Binary>(expr, std::move(operatorToken), right);
+    }
   }
 
   return expr;
 }
 
-std::shared_ptr<Expr> Parser::unary() {
-  if (match(TokenType::BANG, TokenType::MINUS)) {
-    Token operatorToken = previous();
-    std::shared_ptr<Expr> right = unary();
+std::shared_ptr<Expr> Parser::prefix() {
+  DepthScope scope{*this};
+  if (!nest(peek(), "Expression is nested too deeply."))
+    return nullptr;
+
+  switch (peek().getType()) {
+  case TokenType::BANG:
+  case TokenType::MINUS: {
+    Token operatorToken = advance();
+    std::shared_ptr<Expr> right = prefix();
+    if (panicking)
+      return nullptr;
     return std::make_shared<Unary>(std::move(operatorToken), right);
   }
-
-  return primary();
-}
-
-std::shared_ptr<Expr> Parser::primary() {
-  if (match(TokenType::NIL))
+  case TokenType::NIL:
+    advance();
     return std::make_shared<Literal>(nullptr);
-  else if (match(TokenType::TRUE))
+  case TokenType::TRUE:
+    advance();
     return std::make_shared<Literal>(true);
-  else if (match(TokenType::FALSE))
+  case TokenType::FALSE:
+    advance();
     return std::make_shared<Literal>(false);
-  else if (match(TokenType::NUMBER, TokenType::STRING)) {
-    return std::make_shared<Literal>(previous().getLiteral());
-  } else if (match(TokenType::IDENTIFIER)) {
-    return std::make_shared<Variable>(previous());
-  } else if (match(TokenType::LEFT_PAREN)) {
+  case TokenType::NUMBER:
+  case TokenType::STRING:
+    return std::make_shared<Literal>(advance().getLiteral());
+  case TokenType::IDENTIFIER:
+    return std::make_shared<Variable>(advance());
+  case TokenType::LEFT_PAREN: {
+    advance();
     std::shared_ptr<Expr> expr = expression();
-    consume(TokenType::RIGHT_PAREN, "Expect ')' after expression.");
+    if (panicking ||
+        !consume(TokenType::RIGHT_PAREN, "Expect ')' after expression."))
+      return nullptr;
     return std::make_shared<Grouping>(std::move(expr));
-  } else {
-    std::string_view message = "Expect expression.";
-    throw error(peek(), message);
+  }
+  default:
+    error(peek(), "Expect expression.");
+    return nullptr;
   }
 }
 
 template <class... T> bool Parser::match(T... types) {
   assert((std::is_same_v<T, TokenType> && ...));
 
-  for (TokenType type : {types...}) {
-    if (check(type)) {
-      advance();
-      return true;
-    }
+  // Read the next type once instead of checking each type
+  TokenType next = peek().getType();
+  if (next != TokenType::END_OF_FILE && ((next == types) || ...)) {
+    advance();
+    return true;
   }
   return false;
 }
 
 bool Parser::check(TokenType type) const {
-  if (isAtEnd())
-    return false;
-  return peek().getType() == type;
+  // The end of the file never matches
+  TokenType next = peek().getType();
+  return next == type && next != TokenType::END_OF_FILE;
 }
 
 bool Parser::isAtEnd() const {
   return peek().getType() == TokenType::END_OF_FILE;
 }
 
-Token Parser::consume(TokenType type, std::string_view message) {
+const Token *Parser::consume(TokenType type, std::string_view message) {
   if (check(type))
-    return advance();
+    return &advance();
 
-  throw error(peek(), message);
+  error(peek(), message);
+  return nullptr;
 }
 
-Token Parser::advance() {
-  if (!isAtEnd())
+const Token &Parser::advance() {
+  if (!isAtEnd()) {
     current++;
+    if (scanner) {
+      window.push_back(scanner->next());
+      if (window.size() > 2) {
+        window.pop_front();
+      }
+    }
+  }
   return previous();
 }
 
-Token Parser::peek() const { return tokens[current]; }
+const Token &Parser::peek() const {
+  if (scanner) {
+    return window.back();
+  }
+  return static_cast<std::size_t>(current) < tokens.size() ? tokens[current]
+                                                           : *endOfChunk;
+}
 
-Token Parser::previous() const {
+const Token &Parser::previous() const {
   assert(current > 0);
-  return tokens[current - 1];
+  return scanner ? window.front() : tokens[current - 1];
 }
 
-Parser::ParseError Parser::error(const Token &token, std::string_view message) {
-  ::error(token, std::string(message));
-  return ParseError("");
+bool Parser::nest(const Token &token, std::string_view message) {
+  if (++depth > maxDepth) {
+    error(token, message);
+    aborted = true;
+    return false;
+  }
+  return true;
+}
+
+void Parser::setMaxDepth(int limit) { maxDepth = limit; }
+
+void Parser::setLazyBlocks(bool lazy) { lazyBlocks = lazy; }
+
+void Parser::error(const Token &token, std::string_view message) {
+  if (diagnostics) {
+    diagnostics->add(token, std::string(message));
+  } else {
+    ::error(token, std::string(message));
+  }
+  panicking = true;
 }
 
 void Parser::synchronize() {
@@ -1,109 +1,62 @@
 #include "gsc/scanner.hpp"
+#include "gsc/charClass.hpp"
 #include "gsc/error.hpp"
+#include "gsc/numberLiteral.hpp"
+#include <limits>
+#include <thread>
 
-bool isDigit(const char c) { return c >= '0' && c <= '9'; }
-
-bool isAlpha(const char c) {
-  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
-}
-
-bool isAlphaNumeric(const char c) { return isAlpha(c) || isDigit(c); }
-
-void Scanner::addToken(TokenType type) { addToken(type, nullptr); }
-
-void Scanner::addToken(TokenType type, std::any literal) {
-  std::string text{program.substr(start, current - start)};
-  tokens.emplace_back(type, std::move(text), std::move(literal), line);
+void Scanner::addToken(TokenType type) {
+  tokens.emplace_back(type, program.substr(start, current - start), line);
 }
 
 void Scanner::scanToken() {
   char c = advance();
-  switch (c) {
-  // One or two character tokens
-  case '(':
-    addToken(LEFT_PAREN);
-    break;
-  case ')':
-    addToken(RIGHT_PAREN);
-    break;
-  case '{':
-    addToken(LEFT_BRACE);
-    break;
-  case '}':
-    addToken(RIGHT_BRACE);
-    break;
-  case '-':
-    addToken(MINUS);
-    break;
-  case '+':
-    addToken(PLUS);
-    break;
-  case ';':
-    addToken(SEMICOLON);
+  const CharInfo &info = charTable[static_cast<unsigned char>(c)];
+  switch (info.type) {
+  case CharClass::SINGLE:
+    addToken(info.single);
     break;
-  case '*':
-    addToken(STAR);
-    break;
-  case '!':
-    addToken(match('=') ? BANG_EQUAL : BANG);
-    break;
-  case '=':
-    addToken(match('=') ? EQUAL_EQUAL : EQUAL);
-    break;
-  case '<':
-    addToken(match('=') ? LESS_EQUAL : LESS);
-    break;
-  case '>':
-    addToken(match('=') ? GREATER_EQUAL : GREATER);
+
+  // Operators that can be followed by '=' (e.g. '<' and "<=")
+  case CharClass::OPERATOR:
+    addToken(match('=') ? info.withEqual : info.single);
     break;
 
   // Integer division vs. C-style comments
-  case '/':
+  case CharClass::SLASH:
     if (match('/')) {
-      while (peek() != '\n' && !isAtEnd())
-        advance();
+      advanceTo(simd.findLineEnd(currentPosition(), endPosition()));
     } else {
       addToken(SLASH);
     }
     break;
 
-  // Ignore white spaces
-  case ' ':
-  case '\r':
-  case '\t':
+  // Ignore white spaces, skipping the whole run at once (including the new
+  // lines, which are counted)
+  case CharClass::WHITESPACE:
+    advanceTo(simd.skipWhitespace(currentPosition() - 1, endPosition(), line));
     break;
 
-  // New line
-  case '\n':
-    line++;
-    break;
-
-  // Identifiers
-  case '"':
+  case CharClass::QUOTE:
     string();
     break;
-  default:
-    if (isDigit(c)) {
-      number();
-    } else if (isAlpha(c)) {
-      identifier();
-    } else {
-      // Report error but continue scanning
-      error(line, "Unexpected character.");
-    }
+  case CharClass::DIGIT:
+    number();
     break;
-  };
+  case CharClass::ALPHA:
+    identifier();
+    break;
+  case CharClass::INVALID:
+    // Report error but continue scanning
+    reportError("Unexpected character.");
+    break;
+  }
 }
 
 void Scanner::identifier() {
-  while (isAlphaNumeric(peek())) {
-    advance();
-  }
-
-  std::string text = std::string{program.substr(start, current - start)};
+  advanceTo(simd.skipIdentifier(currentPosition(), endPosition()));
 
-  TokenType type = keywords.count(text) ? keywords.at(text) : IDENTIFIER;
-  addToken(type);
+  addToken(keywordType(program.substr(start, current - start)));
 }
 
 void Scanner::number() {
@@ -111,28 +64,39 @@ void Scanner::number() {
     advance();
   }
 
-  int numberLiteral =
-      std::stoi(std::string{program.substr(start, current - start)});
-  addToken(NUMBER, numberLiteral);
+  // Shorter literals always fit, so only the long ones are decoded here
+  std::string_view digits = program.substr(start, current - start);
+  if (digits.size() > std::numeric_limits<int>::digits10 &&
+      !parseNumber(digits)) {
+    reportError("Number literal too large.");
+    // Keep scanning (the program won't run) without a literal to decode
+    tokens.emplace_back(NUMBER, digits, 0, line);
+    return;
+  }
+
+  addToken(NUMBER);
 }
 
 void Scanner::string() {
-  while (peek() != '"' && !isAtEnd()) {
-    if (peek() == '\n')
-      line++;
-    advance();
-  }
+  advanceTo(simd.findStringEnd(currentPosition(), endPosition(), line));
 
   if (isAtEnd()) {
     // Report error but finish scanning without crashing
-    error(line, "Unterminated string.");
+    reportError("Unterminated string.");
     return;
   }
 
   advance();
 
-  std::string word{program.substr(start + 1, current - start - 2)};
-  addToken(STRING, std::move(word));
+  addToken(STRING);
+}
+
+void Scanner::reportError(const std::string &message) {
+  if (deferErrors) {
+    deferredErrors.emplace_back(line, message);
+  } else {
+    error(line, message);
+  }
 }
 
 bool Scanner::match(const char &expected) {
@@ -164,17 +128,204 @@ bool Scanner::isAtEnd() const {
 
 char Scanner::advance() { return program[current++]; }
 
-Scanner::Scanner(std::string_view program) : program{program} {
+void Scanner::advanceTo(const char *position) {
+  current = static_cast<int>(position - program.data());
+}
+
+const char *Scanner::currentPosition() const {
+  return program.data() + current;
+}
+
+const char *Scanner::endPosition() const {
+  return program.data() + program.size();
+}
+
+Scanner::Scanner(std::string_view program, SimdLevel level)
+    : program{program}, simd{scanFunctions(level)} {
   tokens.reserve(256);
 }
 
+Scanner::Scanner(std::string_view chunk, const ScanFunctions &simd, int line)
+    : program{chunk}, line{line}, simd{simd}, deferErrors{true} {
+  // Dense code has about one token every 3 or 4 characters
+  tokens.reserve(chunk.size() / 3 + 1);
+}
+
+void Scanner::scanRemaining() {
+  while (!isAtEnd()) {
+    start = current;
+    scanToken();
+  }
+}
+
+std::vector<Scanner::Split> Scanner::findSplits(std::size_t chunks) const {
+  std::vector<Split> splits{{static_cast<std::size_t>(current), line}};
+  const std::size_t size = program.size() - current;
+  const char *position = currentPosition();
+  const char *end = endPosition();
+  int lines = line;
+
+  while (position < end && splits.size() < chunks) {
+    char c = *position++;
+    if (c == '"') {
+      // Skip the string and its closing quote
+      position = simd.findStringEnd(position, end, lines);
+      position += position < end;
+    } else if (c == '/' && position < end && *position == '/') {
+      // The new line is handled in the next iteration
+      position = simd.findLineEnd(position, end);
+    } else if (c == '\n') {
+      lines++;
+      std::size_t offset = position - program.data();
+      if (offset - current >= splits.size() * size / chunks) {
+        splits.push_back({offset, lines});
+      }
+    }
+  }
+  return splits;
+}
+
 void Scanner::scanTokens() {
+  scanTokens(std::thread::hardware_concurrency());
+}
+
+void Scanner::scanTokens(unsigned threads, std::size_t chunkSize) {
+  const std::size_t chunks =
+      std::min<std::size_t>(std::max(threads, 1u),
+                            (program.size() - current) /
+                                std::max<std::size_t>(chunkSize, 1));
+  std::vector<Split> splits =
+      chunks > 1 ? findSplits(chunks) : std::vector<Split>{};
+
+  if (splits.size() <= 1) {
+    // Growing the vector copies every Token, so reserve enough up front
+    tokens.reserve(tokens.size() + (program.size() - current) / 3 + 1);
+    scanRemaining();
+  } else {
+    std::vector<Scanner> scanners;
+    scanners.reserve(splits.size());
+    for (std::size_t i = 0; i < splits.size(); i++) {
+      std::size_t end =
+          i + 1 < splits.size() ? splits[i + 1].offset : program.size();
+      scanners.push_back(Scanner{
+          program.substr(splits[i].offset, end - splits[i].offset), simd,
+          splits[i].line});
+    }
+
+    // The first chunk is scanned by this thread
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < scanners.size(); i++) {
+      workers.emplace_back([&chunk = scanners[i]] { chunk.scanRemaining(); });
+    }
+    scanners[0].scanRemaining();
+    for (std::thread &worker : workers) {
+      worker.join();
+    }
+
+    // Stitch the chunks together, reporting their errors in source order
+    std::size_t count = tokens.size();
+    for (const Scanner &chunk : scanners) {
+      count += chunk.tokens.size();
+    }
+    tokens.reserve(count + 1);
+    for (const Scanner &chunk : scanners) {
+      for (const auto &[errorLine, message] : chunk.deferredErrors) {
+        error(errorLine, message);
+      }
+      for (const Token &token : chunk.tokens) {
+        tokens.push_back(token);
+      }
+    }
+
+    current = static_cast<int>(program.size());
+    line = scanners.back().line;
+  }
+
+  tokens.emplace_back(END_OF_FILE, program.substr(program.size()), line);
+}
+
+Token Scanner::next() {
+  // Whitespace and comments don't add a token, so scan until one is added
+  tokens.clear();
+  while (tokens.empty() && !isAtEnd()) {
+    start = current;
+    scanToken();
+  }
+
+  if (tokens.empty()) {
+    return Token(END_OF_FILE, program.substr(program.size()), line);
+  }
+  return tokens.back();
+}
+
+std::size_t Scanner::rescan(const std::vector<Token> &previous,
+                            std::string_view previousProgram,
+                            const SourceEdit &edit) {
+  auto offsetOf = [&](const Token &token) {
+    return static_cast<std::ptrdiff_t>(token.getLexeme().data() -
+                                       previousProgram.data());
+  };
+  auto relocate = [&](const Token &token, std::ptrdiff_t shift,
+                      int lineShift) {
+    tokens.push_back(token.relocate(
+        program.substr(offsetOf(token) + shift, token.getLexeme().size()),
+        token.getLine() + lineShift));
+  };
+
+  // Keep the tokens that end before the edit (with a character in between,
+  // or the edit could make them longer)
+  tokens.clear();
+  tokens.reserve(previous.size() + 1);
+  current = 0;
+  line = 1;
+  std::size_t next = 0;
+  for (; next < previous.size() && previous[next].getType() != END_OF_FILE;
+       next++) {
+    const Token &token = previous[next];
+    std::ptrdiff_t end = offsetOf(token) + token.getLexeme().size();
+    if (end >= static_cast<std::ptrdiff_t>(edit.offset)) {
+      break;
+    }
+    relocate(token, 0, 0);
+    current = static_cast<int>(end);
+    // A token is added at the line where it ends
+    line = token.getLine();
+  }
+
+  const std::ptrdiff_t shift = static_cast<std::ptrdiff_t>(edit.inserted) -
+                               static_cast<std::ptrdiff_t>(edit.removed);
+  const std::ptrdiff_t editEnd = edit.offset + edit.removed;
+  std::size_t scanned = 0;
+
   while (!isAtEnd()) {
     start = current;
+    std::size_t count = tokens.size();
     scanToken();
+    if (tokens.size() == count) {
+      continue;
+    }
+    scanned++;
+
+    // Look for a previous token (after the edit) starting at the same place
+    while (next < previous.size() &&
+           (offsetOf(previous[next]) < editEnd ||
+            offsetOf(previous[next]) + shift < start)) {
+      next++;
+    }
+    if (next < previous.size() && offsetOf(previous[next]) + shift == start &&
+        previous[next].getType() != END_OF_FILE) {
+      const int lineShift = tokens.back().getLine() - previous[next].getLine();
+      for (next++; next < previous.size(); next++) {
+        relocate(previous[next], shift, lineShift);
+      }
+      current = static_cast<int>(program.size());
+      line = tokens.back().getLine();
+      return scanned;
+    }
   }
 
-  tokens.emplace_back(END_OF_FILE, "", nullptr, line);
+  tokens.emplace_back(END_OF_FILE, program.substr(program.size()), line);
+  return scanned;
 }
 
-std::vector<Token> Scanner::getTokens() const { return tokens; }
+const std::vector<Token> &Scanner::getTokens() const { return tokens; }
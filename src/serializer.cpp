@@ -0,0 +1,638 @@
+#include "gsc/serializer.hpp"
+#include "gsc/parser.hpp"
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <optional>
+#include <span>
+
+namespace {
+
+/** @internal
+ * @brief The kind of each node (or a missing one, e.g. an if without else).
+ */
+enum class NodeTag : std::uint8_t {
+  NONE,
+  BLOCK,
+  EXPRESSION,
+  PRINT,
+  VAR,
+  IF,
+  WHILE,
+  BINARY,
+  LOGICAL,
+  GROUPING,
+  LITERAL,
+  UNARY,
+  ASSIGN,
+  VARIABLE,
+};
+
+/** @internal
+ * @brief The type of the value of a Literal.
+ */
+enum class LiteralTag : std::uint8_t { NIL, FALSE, TRUE, NUMBER, STRING };
+
+constexpr std::size_t HEADER_SIZE = SERIALIZED_MAGIC.size() + 4;
+
+/** @internal
+ * @brief The tokens that each kind of node can hold, as the Parser builds
+ * them.
+ */
+constexpr std::array BINARY_OPERATORS{MINUS,       PLUS,          SLASH,
+                                      STAR,        BANG_EQUAL,    EQUAL_EQUAL,
+                                      GREATER,     GREATER_EQUAL, LESS,
+                                      LESS_EQUAL};
+constexpr std::array LOGICAL_OPERATORS{AND, OR};
+constexpr std::array UNARY_OPERATORS{BANG, MINUS};
+constexpr std::array NAMES{IDENTIFIER};
+
+/** @internal
+ * @brief Maps signed integers to unsigned ones, so small negative values
+ * are also written in a few bytes.
+ */
+constexpr std::uint32_t zigzag(std::int32_t value) {
+  return (static_cast<std::uint32_t>(value) << 1) ^
+         static_cast<std::uint32_t>(value >> 31);
+}
+
+constexpr std::int32_t unzigzag(std::uint32_t value) {
+  return static_cast<std::int32_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+static_assert(unzigzag(zigzag(-1)) == -1 && zigzag(-1) == 1);
+static_assert(unzigzag(zigzag(std::numeric_limits<std::int32_t>::min())) ==
+              std::numeric_limits<std::int32_t>::min());
+
+/** @internal
+ * @brief The chains of operators add up to Parser::OPERATORS_PER_LEVEL nodes
+ * per level (and the desugared `for` loops 3), so a tree parsed with the
+ * default depth is never this deep.
+ */
+constexpr int MAX_DEPTH =
+    (Parser::OPERATORS_PER_LEVEL + 1) * Parser::DEFAULT_MAX_DEPTH;
+
+/** @internal
+ * @class Reader
+ * @brief Rebuilds the AST reading the nodes in order.
+ */
+class Reader {
+private:
+  std::string_view data;
+  std::size_t position;
+  std::vector<std::string_view> strings;
+  std::uint32_t line = 0;
+  std::optional<std::string_view> source;
+  std::string *restored;
+  bool located = false;
+  std::uint32_t offset = 0;
+  int depth = 0;
+
+  /** @internal
+   * @struct DepthScope
+   * @brief Bounds the recursion, since the data may be corrupted.
+   */
+  struct DepthScope {
+    Reader &reader;
+
+    DepthScope(Reader &reader) : reader(reader) {
+      if (++reader.depth > MAX_DEPTH) {
+        throw FormatError("The serialized program is nested too deeply.");
+      }
+    }
+    ~DepthScope() { reader.depth--; }
+  };
+
+public:
+  /** @internal
+   * @param data The serialized program.
+   * @param position Where the program starts, after the header.
+   * @param source The source code the tokens view, if it's known.
+   * @param restored Where the source code is rebuilt, if it isn't.
+   */
+  Reader(std::string_view data, std::size_t position,
+         std::optional<std::string_view> source, std::string *restored)
+      : data(data), position(position), source(source), restored(restored) {}
+
+  bool isAtEnd() const { return position == data.size(); }
+
+  std::uint8_t readByte() {
+    if (isAtEnd()) {
+      throw FormatError("The serialized program is truncated.");
+    }
+    return static_cast<std::uint8_t>(data[position++]);
+  }
+
+  std::uint32_t readInt() {
+    std::uint32_t value = 0;
+    for (int shift = 0; shift < 32; shift += 7) {
+      std::uint8_t byte = readByte();
+      value |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) {
+        return value;
+      }
+    }
+    throw FormatError("The serialized program has an invalid integer.");
+  }
+
+  /** @internal
+   * @brief Reads the string table, keeping views into the data.
+   */
+  void readStrings() {
+    std::uint32_t count = readInt();
+    // Each string takes at least a byte, so a corrupted count can't reserve
+    // more memory than the size of the data
+    strings.reserve(std::min<std::size_t>(count, data.size()));
+    for (std::uint32_t i = 0; i < count; i++) {
+      std::uint32_t length = readInt();
+      if (data.size() - position < length) {
+        throw FormatError("The serialized program is truncated.");
+      }
+      strings.push_back(data.substr(position, length));
+      position += length;
+    }
+  }
+
+  /** @internal
+   * @brief Reads the size of the source code and where its lines start,
+   * rebuilding them in `restored` if it's set.
+   */
+  void readLocations() {
+    std::uint32_t size = readInt();
+    located = size != 0;
+    if (!located) {
+      if (source && !restored) {
+        throw FormatError("The serialized program has no locations.");
+      }
+      // Without locations the tokens can only view the string table
+      source.reset();
+      return;
+    }
+    size--;
+    if (restored) {
+      restored->assign(size, ' ');
+      source = *restored;
+    } else if (source && source->size() != size) {
+      throw FormatError("The serialized program is of another source.");
+    }
+
+    std::uint32_t count = readInt();
+    std::size_t start = 0;
+    for (std::uint32_t i = 0; i < count; i++) {
+      std::uint32_t length = readInt();
+      start += length;
+      if (length == 0 || start > size) {
+        throw FormatError("The serialized program has an invalid line.");
+      }
+      if (restored) {
+        (*restored)[start - 1] = '\n';
+      }
+    }
+  }
+
+  std::string_view readString() {
+    std::uint32_t index = readInt();
+    if (index >= strings.size()) {
+      throw FormatError("The serialized program has an invalid string.");
+    }
+    return strings[index];
+  }
+
+  /** @internal
+   * @brief Reads a token, which must have one of the given types.
+   */
+  Token readToken(std::span<const TokenType> types) {
+    std::uint8_t type = readByte();
+    if (std::find(types.begin(), types.end(), type) == types.end()) {
+      throw FormatError("The serialized program has an invalid token.");
+    }
+    // Wraps around (instead of overflowing) if the data is corrupted
+    line += static_cast<std::uint32_t>(unzigzag(readInt()));
+    if (located) {
+      offset += static_cast<std::uint32_t>(unzigzag(readInt()));
+    }
+    std::string_view lexeme = readString();
+    if (located && source) {
+      lexeme = readLexeme(lexeme);
+    }
+    return Token(static_cast<TokenType>(type), lexeme, static_cast<int>(line));
+  }
+
+  /** @internal
+   * @brief Finds the text of the token at `offset` in the source code, which
+   * is rebuilt or must have the same text.
+   */
+  std::string_view readLexeme(std::string_view text) {
+    if (offset > source->size() || source->size() - offset < text.size()) {
+      throw FormatError("The serialized program has an invalid location.");
+    }
+    if (restored) {
+      restored->replace(offset, text.size(), text);
+    } else if (source->substr(offset, text.size()) != text) {
+      throw FormatError("The serialized program is of another source.");
+    }
+    return source->substr(offset, text.size());
+  }
+
+  /** @internal
+   * @brief Reads an expression that can't be missing.
+   */
+  std::shared_ptr<Expr> readRequiredExpr() {
+    std::shared_ptr<Expr> expr = readExpr();
+    if (!expr) {
+      throw FormatError("The serialized program has a missing expression.");
+    }
+    return expr;
+  }
+
+  /** @internal
+   * @brief Reads a statement that can't be missing.
+   */
+  std::shared_ptr<Stmt> readRequiredStmt() {
+    std::shared_ptr<Stmt> stmt = readStmt();
+    if (!stmt) {
+      throw FormatError("The serialized program has a missing statement.");
+    }
+    return stmt;
+  }
+
+  std::shared_ptr<Expr> readExpr() {
+    DepthScope scope{*this};
+    switch (static_cast<NodeTag>(readByte())) {
+    case NodeTag::NONE:
+      return nullptr;
+    case NodeTag::BINARY: {
+      std::shared_ptr<Expr> left = readRequiredExpr();
+      Token op = readToken(BINARY_OPERATORS);
+      return std::make_shared<Binary>(left, std::move(op), readRequiredExpr());
+    }
+    case NodeTag::LOGICAL: {
+      std::shared_ptr<Expr> left = readRequiredExpr();
+      Token op = readToken(LOGICAL_OPERATORS);
+      return std::make_shared<Logical>(left, std::move(op),
+                                       readRequiredExpr());
+    }
+    case NodeTag::GROUPING:
+      return std::make_shared<Grouping>(readRequiredExpr());
+    case NodeTag::LITERAL:
+      switch (static_cast<LiteralTag>(readByte())) {
+      case LiteralTag::NIL:
+        return std::make_shared<Literal>(nullptr);
+      case LiteralTag::FALSE:
+        return std::make_shared<Literal>(false);
+      case LiteralTag::TRUE:
+        return std::make_shared<Literal>(true);
+      case LiteralTag::NUMBER:
+        return std::make_shared<Literal>(
+            static_cast<int>(unzigzag(readInt())));
+      case LiteralTag::STRING:
+        return std::make_shared<Literal>(std::string{readString()});
+      default:
+        throw FormatError("The serialized program has an invalid literal.");
+      }
+    case NodeTag::UNARY: {
+      Token op = readToken(UNARY_OPERATORS);
+      return std::make_shared<Unary>(std::move(op), readRequiredExpr());
+    }
+    case NodeTag::ASSIGN: {
+      Token name = readToken(NAMES);
+      return std::make_shared<Assign>(std::move(name), readRequiredExpr());
+    }
+    case NodeTag::VARIABLE:
+      return std::make_shared<Variable>(readToken(NAMES));
+    default:
+      throw FormatError("The serialized program has an invalid expression.");
+    }
+  }
+
+  std::shared_ptr<Stmt> readStmt() {
+    DepthScope scope{*this};
+    switch (static_cast<NodeTag>(readByte())) {
+    case NodeTag::NONE:
+      return nullptr;
+    case NodeTag::BLOCK: {
+      std::uint32_t count = readInt();
+      std::vector<std::shared_ptr<Stmt>> statements;
+      // Each statement takes at least a byte, so a corrupted count can't
+      // reserve more memory than the size of the data
+      statements.reserve(std::min<std::size_t>(count, data.size()));
+      for (std::uint32_t i = 0; i < count; i++) {
+        statements.push_back(readRequiredStmt());
+      }
+      return std::make_shared<Block>(std::move(statements));
+    }
+    case NodeTag::EXPRESSION:
+      return std::make_shared<Expression>(readRequiredExpr());
+    case NodeTag::PRINT:
+      return std::make_shared<Print>(readRequiredExpr());
+    case NodeTag::VAR: {
+      // The initializer is optional
+      Token name = readToken(NAMES);
+      return std::make_shared<Var>(name, readExpr());
+    }
+    case NodeTag::IF: {
+      // The else branch is optional
+      std::shared_ptr<Expr> condition = readRequiredExpr();
+      std::shared_ptr<Stmt> thenBranch = readRequiredStmt();
+      return std::make_shared<If>(condition, thenBranch, readStmt());
+    }
+    case NodeTag::WHILE: {
+      std::shared_ptr<Expr> condition = readRequiredExpr();
+      return std::make_shared<While>(condition, readRequiredStmt());
+    }
+    default:
+      throw FormatError("The serialized program has an invalid statement.");
+    }
+  }
+};
+
+} // namespace
+
+std::string
+Serializer::serialize(const std::vector<std::shared_ptr<Stmt>> &statements) {
+  source = {};
+  map.reset();
+  return serializeProgram(statements);
+}
+
+std::string
+Serializer::serialize(const std::vector<std::shared_ptr<Stmt>> &statements,
+                      std::string_view source) {
+  // The size is written plus one, so 0 means there are no locations
+  if (source.size() >= std::numeric_limits<std::uint32_t>::max()) {
+    throw FormatError("The program is too large to serialize.");
+  }
+  this->source = source;
+  map.emplace(source);
+  return serializeProgram(statements);
+}
+
+std::string Serializer::serializeProgram(
+    const std::vector<std::shared_ptr<Stmt>> &statements) {
+  strings.clear();
+  indexes.clear();
+  nodes.clear();
+  line = 0;
+  offset = 0;
+
+  for (const std::shared_ptr<Stmt> &stmt : statements) {
+    write(stmt);
+  }
+  if (statements.size() > std::numeric_limits<std::uint32_t>::max()) {
+    throw FormatError("The program is too large to serialize.");
+  }
+
+  // The header and the string table are written after the nodes, since the
+  // nodes add the strings
+  std::string body;
+  body.swap(nodes);
+  nodes += SERIALIZED_MAGIC;
+  for (int i = 0; i < 4; i++) {
+    writeByte(static_cast<std::uint8_t>(SERIALIZED_VERSION >> (8 * i)));
+  }
+  writeInt(static_cast<std::uint32_t>(statements.size()));
+  writeInt(static_cast<std::uint32_t>(strings.size()));
+  for (std::string_view text : strings) {
+    writeInt(static_cast<std::uint32_t>(text.size()));
+    nodes += text;
+  }
+  if (map) {
+    writeInt(static_cast<std::uint32_t>(source.size() + 1));
+    // The lines are written as their lengths, without the first start
+    const std::vector<std::size_t> &starts = map->getLineStarts();
+    writeInt(static_cast<std::uint32_t>(starts.size() - 1));
+    for (std::size_t i = 1; i < starts.size(); i++) {
+      writeInt(static_cast<std::uint32_t>(starts[i] - starts[i - 1]));
+    }
+  } else {
+    writeInt(0);
+  }
+  nodes += body;
+
+  std::string data;
+  data.swap(nodes);
+  return data;
+}
+
+void Serializer::writeByte(std::uint8_t value) {
+  nodes.push_back(static_cast<char>(value));
+}
+
+void Serializer::writeInt(std::uint32_t value) {
+  // 7 bits per byte, with the highest bit set if more bytes follow
+  while (value >= 0x80) {
+    writeByte(static_cast<std::uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  writeByte(static_cast<std::uint8_t>(value));
+}
+
+void Serializer::writeString(std::string_view text) {
+  // Every occurrence of a name shares its entry in the string table
+  auto [it, inserted] =
+      indexes.try_emplace(text, static_cast<std::uint32_t>(strings.size()));
+  if (inserted) {
+    strings.push_back(text);
+  }
+  writeInt(it->second);
+}
+
+void Serializer::writeToken(const Token &token) {
+  writeByte(static_cast<std::uint8_t>(token.getType()));
+  // The lines are written as the difference with the previous token
+  writeInt(zigzag(token.getLine() - line));
+  line = token.getLine();
+  if (map) {
+    if (!map->contains(token.getLexeme())) {
+      throw FormatError("A token isn't in the source code.");
+    }
+    // The offsets too, wrapping around like the lines when they go back
+    auto tokenOffset =
+        static_cast<std::uint32_t>(token.getLexeme().data() - source.data());
+    writeInt(zigzag(static_cast<std::int32_t>(tokenOffset - offset)));
+    offset = tokenOffset;
+  }
+  writeString(token.getLexeme());
+}
+
+void Serializer::write(const std::shared_ptr<Expr> &expr) {
+  if (expr) {
+    expr->accept(*this);
+  } else {
+    writeByte(static_cast<std::uint8_t>(NodeTag::NONE));
+  }
+}
+
+void Serializer::write(const std::shared_ptr<Stmt> &stmt) {
+  if (stmt) {
+    stmt->accept(*this);
+  } else {
+    writeByte(static_cast<std::uint8_t>(NodeTag::NONE));
+  }
+}
+
+std::any Serializer::visitBinaryExpr(std::shared_ptr<Binary> expr) {
+  writeByte(static_cast<std::uint8_t>(NodeTag::BINARY));
+  write(expr->getLeft());
+  writeToken(expr->getOp());
+  write(expr->getRight());
+  return {};
+}
+
+std::any Serializer::visitLogicalExpr(std::shared_ptr<Logical> expr) {
+  writeByte(static_cast<std::uint8_t>(NodeTag::LOGICAL));
+  write(expr->getLeft());
+  writeToken(expr->getOp());
+  write(expr->getRight());
+  return {};
+}
+
+std::any Serializer::visitGroupingExpr(std::shared_ptr<Grouping> expr) {
+  writeByte(static_cast<std::uint8_t>(NodeTag::GROUPING));
+  write(expr->getExpression());
+  return {};
+}
+
+std::any Serializer::visitLiteralExpr(std::shared_ptr<Literal> expr) {
+  writeByte(static_cast<std::uint8_t>(NodeTag::LITERAL));
+  const std::any &value = expr->getValue();
+  if (!value.has_value() || value.type() == typeid(std::nullptr_t)) {
+    writeByte(static_cast<std::uint8_t>(LiteralTag::NIL));
+  } else if (const bool *boolean = std::any_cast<bool>(&value)) {
+    writeByte(static_cast<std::uint8_t>(*boolean ? LiteralTag::TRUE
+                                                 : LiteralTag::FALSE));
+  } else if (const int *number = std::any_cast<int>(&value)) {
+    writeByte(static_cast<std::uint8_t>(LiteralTag::NUMBER));
+    writeInt(zigzag(*number));
+  } else if (const std::string *text = std::any_cast<std::string>(&value)) {
+    writeByte(static_cast<std::uint8_t>(LiteralTag::STRING));
+    writeString(*text);
+  } else {
+    throw FormatError("Can't serialize a literal of this type.");
+  }
+  return {};
+}
+
+std::any Serializer::visitUnaryExpr(std::shared_ptr<Unary> expr) {
+  writeByte(static_cast<std::uint8_t>(NodeTag::UNARY));
+  writeToken(expr->getOp());
+  write(expr->getRight());
+  return {};
+}
+
+std::any Serializer::visitAssignExpr(std::shared_ptr<Assign> expr) {
+  writeByte(static_cast<std::uint8_t>(NodeTag::ASSIGN));
+  writeToken(expr->getName());
+  write(expr->getValue());
+  return {};
+}
+
+std::any Serializer::visitVariableExpr(std::shared_ptr<Variable> expr) {
+  writeByte(static_cast<std::uint8_t>(NodeTag::VARIABLE));
+  writeToken(expr->getName());
+  return {};
+}
+
+std::any Serializer::visitBlockStmt(std::shared_ptr<Block> stmt) {
+  const std::vector<std::shared_ptr<Stmt>> &statements =
+      stmt->getStatements();
+  writeByte(static_cast<std::uint8_t>(NodeTag::BLOCK));
+  writeInt(static_cast<std::uint32_t>(statements.size()));
+  for (const std::shared_ptr<Stmt> &statement : statements) {
+    write(statement);
+  }
+  return {};
+}
+
+std::any Serializer::visitExpressionStmt(std::shared_ptr<Expression> stmt) {
+  writeByte(static_cast<std::uint8_t>(NodeTag::EXPRESSION));
+  write(stmt->getExpression());
+  return {};
+}
+
+std::any Serializer::visitPrintStmt(std::shared_ptr<Print> stmt) {
+  writeByte(static_cast<std::uint8_t>(NodeTag::PRINT));
+  write(stmt->getExpression());
+  return {};
+}
+
+std::any Serializer::visitVarStmt(std::shared_ptr<Var> stmt) {
+  writeByte(static_cast<std::uint8_t>(NodeTag::VAR));
+  writeToken(stmt->getName());
+  write(stmt->getInitializer());
+  return {};
+}
+
+std::any Serializer::visitIfStmt(std::shared_ptr<If> stmt) {
+  writeByte(static_cast<std::uint8_t>(NodeTag::IF));
+  write(stmt->getCondition());
+  write(stmt->getThenBranch());
+  write(stmt->getElseBranch());
+  return {};
+}
+
+std::any Serializer::visitWhileStmt(std::shared_ptr<While> stmt) {
+  writeByte(static_cast<std::uint8_t>(NodeTag::WHILE));
+  write(stmt->getCondition());
+  write(stmt->getBody());
+  return {};
+}
+
+bool isSerialized(std::string_view data) {
+  return data.starts_with(SERIALIZED_MAGIC);
+}
+
+namespace {
+
+/** @internal
+ * @brief Loads a serialized program, with the tokens viewing the source code
+ * if it's known, the rebuilt one if `restored` is set, or else the data.
+ */
+std::vector<std::shared_ptr<Stmt>>
+deserializeProgram(std::string_view data,
+                   std::optional<std::string_view> source,
+                   std::string *restored) {
+  if (!isSerialized(data) || data.size() < HEADER_SIZE) {
+    throw FormatError("Not a serialized program.");
+  }
+  std::uint32_t version = 0;
+  for (int i = 3; i >= 0; i--) {
+    version = version << 8 |
+              static_cast<unsigned char>(data[SERIALIZED_MAGIC.size() + i]);
+  }
+  if (version != SERIALIZED_VERSION) {
+    throw FormatError("The serialized program has another version.");
+  }
+
+  Reader reader{data, HEADER_SIZE, source, restored};
+  std::uint32_t count = reader.readInt();
+  reader.readStrings();
+  reader.readLocations();
+
+  std::vector<std::shared_ptr<Stmt>> statements;
+  statements.reserve(std::min<std::size_t>(count, data.size()));
+  for (std::uint32_t i = 0; i < count; i++) {
+    statements.push_back(reader.readRequiredStmt());
+  }
+  if (!reader.isAtEnd()) {
+    throw FormatError("The serialized program has trailing data.");
+  }
+  return statements;
+}
+
+} // namespace
+
+std::vector<std::shared_ptr<Stmt>> deserialize(std::string_view data) {
+  return deserializeProgram(data, std::nullopt, nullptr);
+}
+
+std::vector<std::shared_ptr<Stmt>> deserialize(std::string_view data,
+                                               std::string_view source) {
+  return deserializeProgram(data, source, nullptr);
+}
+
+std::vector<std::shared_ptr<Stmt>> deserializeRestoring(std::string_view data,
+                                                        std::string &source) {
+  source.clear();
+  return deserializeProgram(data, source, &source);
+}
@@ -0,0 +1,283 @@
+#include "gsc/simdScan.hpp"
+#include "gsc/charClass.hpp"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define GSC_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Scalar versions, used for the tails of the buffer and when there's no SIMD
+
+const char *skipWhitespaceScalar(const char *current, const char *end,
+                                 int &newlines) {
+  while (current < end && isWhitespace(*current)) {
+    newlines += *current == '\n';
+    current++;
+  }
+  return current;
+}
+
+const char *skipIdentifierScalar(const char *current, const char *end) {
+  while (current < end && isAlphaNumeric(*current)) {
+    current++;
+  }
+  return current;
+}
+
+const char *findStringEndScalar(const char *current, const char *end,
+                                int &newlines) {
+  while (current < end && *current != '"') {
+    newlines += *current == '\n';
+    current++;
+  }
+  return current;
+}
+
+const char *findLineEndScalar(const char *current, const char *end) {
+  while (current < end && *current != '\n') {
+    current++;
+  }
+  return current;
+}
+
+#ifdef GSC_X86_SIMD
+
+// Number of set bits of a mask below the given bit
+int countBelow(unsigned mask, int bit) {
+  return __builtin_popcount(mask & ((1u << bit) - 1));
+}
+
+// SSE2 versions (16 bytes at a time)
+
+__m128i whitespaceMask16(__m128i chunk, __m128i &newline) {
+  newline = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'));
+  __m128i space = _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' '));
+  __m128i tab = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'));
+  __m128i carriage = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'));
+  return _mm_or_si128(_mm_or_si128(newline, space),
+                      _mm_or_si128(tab, carriage));
+}
+
+// Bytes in [low, high] (only for ASCII bounds, since the comparison is signed)
+__m128i inRange16(__m128i chunk, char low, char high) {
+  return _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8(low - 1)),
+                       _mm_cmplt_epi8(chunk, _mm_set1_epi8(high + 1)));
+}
+
+__m128i identifierMask16(__m128i chunk) {
+  // Setting the 0x20 bit maps the uppercase letters to the lowercase ones
+  __m128i letter =
+      inRange16(_mm_or_si128(chunk, _mm_set1_epi8(0x20)), 'a', 'z');
+  __m128i digit = inRange16(chunk, '0', '9');
+  __m128i underscore = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_'));
+  return _mm_or_si128(_mm_or_si128(letter, digit), underscore);
+}
+
+const char *skipWhitespaceSse2(const char *current, const char *end,
+                               int &newlines) {
+  while (end - current >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(current));
+    __m128i newline;
+    unsigned whitespace = _mm_movemask_epi8(whitespaceMask16(chunk, newline));
+    unsigned lines = _mm_movemask_epi8(newline);
+
+    if (whitespace != 0xFFFF) {
+      int run = __builtin_ctz(~whitespace);
+      newlines += countBelow(lines, run);
+      return current + run;
+    }
+    newlines += __builtin_popcount(lines);
+    current += 16;
+  }
+  return skipWhitespaceScalar(current, end, newlines);
+}
+
+const char *skipIdentifierSse2(const char *current, const char *end) {
+  while (end - current >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(current));
+    unsigned identifier = _mm_movemask_epi8(identifierMask16(chunk));
+
+    if (identifier != 0xFFFF) {
+      return current + __builtin_ctz(~identifier);
+    }
+    current += 16;
+  }
+  return skipIdentifierScalar(current, end);
+}
+
+const char *findStringEndSse2(const char *current, const char *end,
+                              int &newlines) {
+  while (end - current >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(current));
+    unsigned quotes =
+        _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')));
+    unsigned lines =
+        _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')));
+
+    if (quotes) {
+      int run = __builtin_ctz(quotes);
+      newlines += countBelow(lines, run);
+      return current + run;
+    }
+    newlines += __builtin_popcount(lines);
+    current += 16;
+  }
+  return findStringEndScalar(current, end, newlines);
+}
+
+const char *findLineEndSse2(const char *current, const char *end) {
+  while (end - current >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(current));
+    unsigned lines =
+        _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')));
+
+    if (lines) {
+      return current + __builtin_ctz(lines);
+    }
+    current += 16;
+  }
+  return findLineEndScalar(current, end);
+}
+
+// AVX2 versions (32 bytes at a time), only called if the CPU supports them
+
+#define GSC_AVX2 __attribute__((target("avx2")))
+
+GSC_AVX2 __m256i whitespaceMask32(__m256i chunk, __m256i &newline) {
+  newline = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n'));
+  __m256i space = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' '));
+  __m256i tab = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'));
+  __m256i carriage = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r'));
+  return _mm256_or_si256(_mm256_or_si256(newline, space),
+                         _mm256_or_si256(tab, carriage));
+}
+
+GSC_AVX2 __m256i inRange32(__m256i chunk, char low, char high) {
+  return _mm256_and_si256(
+      _mm256_cmpgt_epi8(chunk, _mm256_set1_epi8(low - 1)),
+      _mm256_cmpgt_epi8(_mm256_set1_epi8(high + 1), chunk));
+}
+
+GSC_AVX2 __m256i identifierMask32(__m256i chunk) {
+  __m256i letter =
+      inRange32(_mm256_or_si256(chunk, _mm256_set1_epi8(0x20)), 'a', 'z');
+  __m256i digit = inRange32(chunk, '0', '9');
+  __m256i underscore = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('_'));
+  return _mm256_or_si256(_mm256_or_si256(letter, digit), underscore);
+}
+
+GSC_AVX2 const char *skipWhitespaceAvx2(const char *current, const char *end,
+                                        int &newlines) {
+  while (end - current >= 32) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(current));
+    __m256i newline;
+    unsigned whitespace =
+        _mm256_movemask_epi8(whitespaceMask32(chunk, newline));
+    unsigned lines = _mm256_movemask_epi8(newline);
+
+    if (whitespace != 0xFFFFFFFF) {
+      int run = __builtin_ctz(~whitespace);
+      newlines += countBelow(lines, run);
+      return current + run;
+    }
+    newlines += __builtin_popcount(lines);
+    current += 32;
+  }
+  return skipWhitespaceSse2(current, end, newlines);
+}
+
+GSC_AVX2 const char *skipIdentifierAvx2(const char *current,
+                                        const char *end) {
+  while (end - current >= 32) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(current));
+    unsigned identifier = _mm256_movemask_epi8(identifierMask32(chunk));
+
+    if (identifier != 0xFFFFFFFF) {
+      return current + __builtin_ctz(~identifier);
+    }
+    current += 32;
+  }
+  return skipIdentifierSse2(current, end);
+}
+
+GSC_AVX2 const char *findStringEndAvx2(const char *current, const char *end,
+                                       int &newlines) {
+  while (end - current >= 32) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(current));
+    unsigned quotes =
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"')));
+    unsigned lines = _mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')));
+
+    if (quotes) {
+      int run = __builtin_ctz(quotes);
+      newlines += countBelow(lines, run);
+      return current + run;
+    }
+    newlines += __builtin_popcount(lines);
+    current += 32;
+  }
+  return findStringEndSse2(current, end, newlines);
+}
+
+GSC_AVX2 const char *findLineEndAvx2(const char *current, const char *end) {
+  while (end - current >= 32) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(current));
+    unsigned lines = _mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')));
+
+    if (lines) {
+      return current + __builtin_ctz(lines);
+    }
+    current += 32;
+  }
+  return findLineEndSse2(current, end);
+}
+
+#undef GSC_AVX2
+
+#endif
+
+const ScanFunctions scalarFunctions{skipWhitespaceScalar, skipIdentifierScalar,
+                                    findStringEndScalar, findLineEndScalar};
+
+#ifdef GSC_X86_SIMD
+const ScanFunctions sse2Functions{skipWhitespaceSse2, skipIdentifierSse2,
+                                  findStringEndSse2, findLineEndSse2};
+
+const ScanFunctions avx2Functions{skipWhitespaceAvx2, skipIdentifierAvx2,
+                                  findStringEndAvx2, findLineEndAvx2};
+#endif
+
+} // namespace
+
+SimdLevel detectSimdLevel() {
+#ifdef GSC_X86_SIMD
+  static const SimdLevel level = __builtin_cpu_supports("avx2")
+                                     ? SimdLevel::AVX2
+                                     : SimdLevel::SSE2;
+  return level;
+#else
+  return SimdLevel::SCALAR;
+#endif
+}
+
+const ScanFunctions &scanFunctions(SimdLevel level) {
+#ifdef GSC_X86_SIMD
+  // Never use instructions the CPU doesn't have
+  if (level == SimdLevel::AVX2 && detectSimdLevel() == SimdLevel::AVX2) {
+    return avx2Functions;
+  } else if (level != SimdLevel::SCALAR) {
+    return sse2Functions;
+  }
+#else
+  (void)level;
+#endif
+  return scalarFunctions;
+}
@@ -0,0 +1,71 @@
+#include "gsc/sourceFile.hpp"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace {
+
+std::system_error fileError(const std::string &path) {
+  return std::system_error(errno, std::generic_category(),
+                           "Could not open file: " + path);
+}
+
+} // namespace
+
+SourceFile::SourceFile(const std::string &path) {
+  const bool standardInput = path == "-";
+  int fd = standardInput ? STDIN_FILENO : open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw fileError(path);
+  }
+
+  struct stat status;
+  if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode) &&
+      status.st_size > 0) {
+    size = static_cast<std::size_t>(status.st_size);
+    void *pages = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (pages != MAP_FAILED) {
+      madvise(pages, size, MADV_SEQUENTIAL); // The Scanner reads it in order
+      data = static_cast<const char *>(pages);
+      mapped = true;
+    }
+  }
+
+  if (!mapped) {
+    // Fall back to reading the file in big blocks
+    char block[1 << 16];
+    ssize_t count;
+    while ((count = read(fd, block, sizeof(block))) != 0) {
+      if (count < 0 && errno != EINTR) {
+        std::system_error error = fileError(path);
+        if (!standardInput) {
+          close(fd);
+        }
+        throw error;
+      }
+      if (count > 0) {
+        buffer.append(block, static_cast<std::size_t>(count));
+      }
+    }
+    data = buffer.data();
+    size = buffer.size();
+  }
+
+  // The mapping stays valid after closing the file
+  if (!standardInput) {
+    close(fd);
+  }
+}
+
+SourceFile::~SourceFile() {
+  if (mapped) {
+    munmap(const_cast<char *>(data), size);
+  }
+}
+
+std::string_view SourceFile::getContent() const { return {data, size}; }
+
+bool SourceFile::isMapped() const { return mapped; }
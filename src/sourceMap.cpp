@@ -0,0 +1,58 @@
+#include "gsc/sourceMap.hpp"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+SourceMap::SourceMap(std::string_view source) : source(source) {
+  lineStarts.push_back(0);
+  const char *begin = source.data();
+  const char *end = begin + source.size();
+  for (const char *c = begin; c != end;) {
+    c = static_cast<const char *>(std::memchr(c, '\n', end - c));
+    if (!c) {
+      break;
+    }
+    lineStarts.push_back(++c - begin);
+  }
+}
+
+bool SourceMap::contains(std::string_view lexeme) const {
+  // The lexeme may point into another buffer, which only std::less orders
+  std::less<const char *> before;
+  return !before(lexeme.data(), source.data()) &&
+         !before(source.data() + source.size(),
+                 lexeme.data() + lexeme.size());
+}
+
+SourceLocation SourceMap::locate(std::size_t offset) const {
+  auto next = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset);
+  auto line = next - lineStarts.begin();
+  return {static_cast<int>(line),
+          static_cast<int>(offset - *std::prev(next)) + 1};
+}
+
+std::optional<SourceLocation>
+SourceMap::locate(std::string_view lexeme) const {
+  if (!contains(lexeme)) {
+    return std::nullopt;
+  }
+  return locate(static_cast<std::size_t>(lexeme.data() - source.data()));
+}
+
+const std::vector<std::size_t> &SourceMap::getLineStarts() const {
+  return lineStarts;
+}
+
+std::string_view SourceMap::getLine(int line) const {
+  if (line < 1 || line > getLineCount()) {
+    return {};
+  }
+  std::size_t begin = lineStarts[line - 1];
+  std::size_t end = line < getLineCount() ? lineStarts[line] - 1
+                                          : source.size();
+  return source.substr(begin, end - begin);
+}
+
+int SourceMap::getLineCount() const {
+  return static_cast<int>(lineStarts.size());
+}
@@ -1,20 +1,48 @@
 #include "gsc/token.hpp"
+#include "gsc/numberLiteral.hpp"
+#include <stdexcept>
 #include <utility>
 
-Token::Token(TokenType type, std::string lexeme, std::any literal, int line)
-    : type{type}, lexeme{std::move(lexeme)}, literal{std::move(literal)},
-      line{line} {}
+Token::Token(TokenType type, std::string_view lexeme, std::any literal,
+             int line)
+    : type{type}, line{line}, lexeme{lexeme}, literal{std::move(literal)} {}
+
+Token::Token(TokenType type, std::string_view lexeme, int line)
+    : type{type}, line{line}, lexeme{lexeme} {}
 
 TokenType Token::getType() const { return type; }
 
-std::string Token::getLexeme() const { return lexeme; }
+std::string_view Token::getLexeme() const { return lexeme; }
+
+std::any Token::getLiteral() const {
+  if (literal.has_value()) {
+    return literal;
+  }
 
-std::any Token::getLiteral() const { return literal; }
+  switch (type) {
+  case (NUMBER): {
+    std::optional<int> number = parseNumber(lexeme);
+    if (!number) {
+      throw std::out_of_range("Number literal out of range");
+    }
+    return *number;
+  }
+  case (STRING):
+    return std::string{lexeme.substr(1, lexeme.size() - 2)};
+  default:
+    return nullptr;
+  }
+}
 
 int Token::getLine() const { return line; }
 
+Token Token::relocate(std::string_view lexeme, int line) const {
+  return Token{type, lexeme, literal, line};
+}
+
 std::string Token::toString() const {
   std::string literal_str;
+  std::any value = getLiteral();
 
   switch (type) {
   case (TRUE):
@@ -24,23 +52,23 @@ std::string Token::toString() const {
     literal_str = "false";
     break;
   case (NUMBER):
-    literal_str = std::to_string(std::any_cast<int>(literal));
+    literal_str = std::to_string(std::any_cast<int>(value));
     break;
   case (STRING):
     try {
-      literal_str = std::any_cast<std::string>(literal);
+      literal_str = std::any_cast<std::string>(value);
     } catch (const std::bad_any_cast &e) {
       literal_str =
-          static_cast<std::string>(std::any_cast<const char *>(literal));
+          static_cast<std::string>(std::any_cast<const char *>(value));
     }
     break;
   case (IDENTIFIER):
-    literal_str = lexeme;
+    literal_str = std::string{lexeme};
     break;
   default:
     literal_str = "nil";
     break;
   }
 
-  return ::toString(type) + " " + lexeme + " " + literal_str;
+  return ::toString(type) + " " + std::string{lexeme} + " " + literal_str;
 }
@@ -0,0 +1,366 @@
+#include "gsc/typeInference.hpp"
+#include <algorithm>
+#include <span>
+
+std::string toString(InferredType type) {
+  switch (type) {
+  case InferredType::UNDEFINED:
+    return "undefined";
+  case InferredType::NIL:
+    return "nil";
+  case InferredType::BOOL:
+    return "bool";
+  case InferredType::INT:
+    return "int";
+  case InferredType::STRING:
+    return "string";
+  default:
+    return "any";
+  }
+}
+
+void TypeInference::analyze(
+    const std::vector<std::shared_ptr<Stmt>> &statements) {
+  scopes.assign(1, {});
+  trail.clear();
+  declarations.clear();
+  declarationIds.clear();
+  operandTypes.clear();
+
+  for (const std::shared_ptr<Stmt> &stmt : statements) {
+    analyze(stmt);
+    // No branch is open anymore, so these changes won't be undone
+    trail.clear();
+  }
+
+  for (auto &[binary, operandType] : operandTypes) {
+    binary->setOperandType(operandType);
+  }
+  operandTypes.clear();
+}
+
+void TypeInference::dump(std::ostream &out) const {
+  for (const Declaration &declaration : declarations) {
+    out << declaration.name << " (line " << declaration.line
+        << "): " << toString(declaration.type) << "\n";
+  }
+  out << "monomorphic: " << (isMonomorphic() ? "yes" : "no") << "\n";
+}
+
+bool TypeInference::isMonomorphic() const {
+  return std::none_of(declarations.begin(), declarations.end(),
+                      [](const Declaration &declaration) {
+                        return declaration.type == InferredType::ANY;
+                      });
+}
+
+InferredType TypeInference::infer(std::shared_ptr<Expr> expr) {
+  return std::any_cast<InferredType>(expr->accept(*this));
+}
+
+void TypeInference::analyze(std::shared_ptr<Stmt> stmt) {
+  if (stmt) {
+    stmt->accept(*this);
+  }
+}
+
+TypeInference::Slot *TypeInference::lookup(std::string_view name) {
+  for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
+    auto it = scope->find(name);
+    if (it != scope->end()) {
+      return &it->second;
+    }
+  }
+  return nullptr;
+}
+
+void TypeInference::write(std::string_view name, InferredType type) {
+  for (std::size_t scope = scopes.size(); scope-- > 0;) {
+    auto it = scopes[scope].find(name);
+    if (it != scopes[scope].end()) {
+      Slot slot = it->second;
+      slot.type = type;
+      set(scope, name, slot);
+
+      Declaration &declaration = declarations[slot.declaration];
+      declaration.type = join(declaration.type, type);
+      return;
+    }
+  }
+  // Not declared in this program, so nothing is known about it
+}
+
+std::optional<TypeInference::Slot>
+TypeInference::get(std::size_t scope, std::string_view name) const {
+  auto it = scopes[scope].find(name);
+  if (it == scopes[scope].end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+void TypeInference::set(std::size_t scope, std::string_view name,
+                        std::optional<Slot> slot) {
+  std::optional<Slot> previous = get(scope, name);
+  if (previous != slot) {
+    trail.push_back({scope, name, std::move(previous)});
+    replace(scope, name, slot);
+  }
+}
+
+void TypeInference::replace(std::size_t scope, std::string_view name,
+                            const std::optional<Slot> &slot) {
+  auto it = scopes[scope].find(name);
+  if (!slot) {
+    if (it != scopes[scope].end()) {
+      scopes[scope].erase(it);
+    }
+  } else if (it != scopes[scope].end()) {
+    it->second = *slot;
+  } else {
+    scopes[scope].emplace(std::string{name}, *slot);
+  }
+}
+
+TypeInference::Changes TypeInference::changedSince(std::size_t mark) const {
+  Changes changes;
+  for (std::size_t i = mark; i < trail.size(); i++) {
+    // The first change of a slot has its value at the mark
+    changes.try_emplace({trail[i].scope, trail[i].name}, trail[i].previous);
+  }
+  return changes;
+}
+
+TypeInference::Changes TypeInference::currentSince(std::size_t mark) const {
+  Changes changes;
+  for (std::size_t i = mark; i < trail.size(); i++) {
+    changes.try_emplace({trail[i].scope, trail[i].name},
+                        get(trail[i].scope, trail[i].name));
+  }
+  return changes;
+}
+
+void TypeInference::undo(std::size_t mark) {
+  while (trail.size() > mark) {
+    replace(trail.back().scope, trail.back().name, trail.back().previous);
+    trail.pop_back();
+  }
+}
+
+InferredType TypeInference::join(InferredType a, InferredType b) {
+  if (a == b || b == InferredType::UNDEFINED) {
+    return a;
+  } else if (a == InferredType::UNDEFINED) {
+    return b;
+  }
+  return InferredType::ANY;
+}
+
+std::optional<TypeInference::Slot>
+TypeInference::join(const std::optional<Slot> &a,
+                    const std::optional<Slot> &b) {
+  if (a && b && a->declaration == b->declaration) {
+    return Slot{join(a->type, b->type), a->declaration};
+  } else if (a) {
+    return Slot{InferredType::ANY, a->declaration};
+  } else if (b) {
+    return Slot{InferredType::ANY, b->declaration};
+  }
+  return std::nullopt;
+}
+
+std::any TypeInference::visitBinaryExpr(std::shared_ptr<Binary> expr) {
+  InferredType left = infer(expr->getLeft());
+  InferredType right = infer(expr->getRight());
+
+  OperandType observed = OperandType::UNKNOWN;
+  if (left == InferredType::INT && right == InferredType::INT) {
+    observed = OperandType::INT;
+  } else if (left == InferredType::STRING && right == InferredType::STRING) {
+    observed = OperandType::STRING;
+  }
+
+  // A node can be visited more than once (loops), so keep the join of all
+  // the observations
+  auto [it, inserted] = operandTypes.try_emplace(expr.get(), observed);
+  if (!inserted && it->second != observed) {
+    it->second = OperandType::UNKNOWN;
+  }
+
+  switch (expr->getOp().getType()) {
+  case TokenType::PLUS:
+    if (observed == OperandType::INT) {
+      return InferredType::INT;
+    } else if (observed == OperandType::STRING) {
+      return InferredType::STRING;
+    }
+    return InferredType::ANY;
+  case TokenType::MINUS:
+  case TokenType::STAR:
+  case TokenType::SLASH:
+    // If the evaluation doesn't fail, the result is always a number
+    return InferredType::INT;
+  default:
+    return InferredType::BOOL;
+  }
+}
+
+std::any TypeInference::visitLogicalExpr(std::shared_ptr<Logical> expr) {
+  InferredType left = infer(expr->getLeft());
+
+  // The right operand may not be evaluated (short-circuit)
+  std::size_t afterLeft = trail.size();
+  InferredType right = infer(expr->getRight());
+  for (const auto &[key, value] : changedSince(afterLeft)) {
+    set(key.first, key.second, join(value, get(key.first, key.second)));
+  }
+
+  return join(left, right);
+}
+
+std::any TypeInference::visitGroupingExpr(std::shared_ptr<Grouping> expr) {
+  return infer(expr->getExpression());
+}
+
+std::any TypeInference::visitLiteralExpr(std::shared_ptr<Literal> expr) {
+  const std::type_info &type = expr->getValue().type();
+  if (type == typeid(int)) {
+    return InferredType::INT;
+  } else if (type == typeid(std::string)) {
+    return InferredType::STRING;
+  } else if (type == typeid(bool)) {
+    return InferredType::BOOL;
+  } else if (type == typeid(std::nullptr_t)) {
+    return InferredType::NIL;
+  }
+  return InferredType::ANY;
+}
+
+std::any TypeInference::visitUnaryExpr(std::shared_ptr<Unary> expr) {
+  infer(expr->getRight());
+  return expr->getOp().getType() == TokenType::MINUS ? InferredType::INT
+                                                     : InferredType::BOOL;
+}
+
+std::any TypeInference::visitAssignExpr(std::shared_ptr<Assign> expr) {
+  InferredType type = infer(expr->getValue());
+  write(expr->getName().getLexeme(), type);
+  return type;
+}
+
+std::any TypeInference::visitVariableExpr(std::shared_ptr<Variable> expr) {
+  Slot *slot = lookup(expr->getName().getLexeme());
+  return slot ? slot->type : InferredType::ANY;
+}
+
+std::any TypeInference::visitBlockStmt(std::shared_ptr<Block> stmt) {
+  if (stmt->isDeferred()) {
+    // Without its statements, any variable assigned in the block (or
+    // shadowed, with `var name =`) can have any type after it
+    std::span<const Token> tokens = stmt->getTokens();
+    for (std::size_t i = 0; i + 1 < tokens.size(); i++) {
+      if (tokens[i].getType() == TokenType::IDENTIFIER &&
+          tokens[i + 1].getType() == TokenType::EQUAL) {
+        write(tokens[i].getLexeme(), InferredType::ANY);
+      }
+    }
+    return {};
+  }
+
+  std::size_t mark = trail.size();
+  scopes.emplace_back();
+  for (const std::shared_ptr<Stmt> &inner : stmt->getStatements()) {
+    analyze(inner);
+  }
+
+  // The slots of the block are gone with it, so their changes can't be undone
+  std::size_t scope = scopes.size() - 1;
+  trail.erase(std::remove_if(trail.begin() + mark, trail.end(),
+                             [scope](const Change &change) {
+                               return change.scope == scope;
+                             }),
+              trail.end());
+  scopes.pop_back();
+  return {};
+}
+
+std::any TypeInference::visitExpressionStmt(std::shared_ptr<Expression> stmt) {
+  infer(stmt->getExpression());
+  return {};
+}
+
+std::any TypeInference::visitPrintStmt(std::shared_ptr<Print> stmt) {
+  infer(stmt->getExpression());
+  return {};
+}
+
+std::any TypeInference::visitIfStmt(std::shared_ptr<If> stmt) {
+  infer(stmt->getCondition());
+
+  std::size_t entry = trail.size();
+  analyze(stmt->getThenBranch());
+  Changes afterThen = currentSince(entry);
+
+  undo(entry);
+  analyze(stmt->getElseBranch());
+
+  // Only the slots changed by a branch can differ between both of them
+  for (const auto &[key, value] : afterThen) {
+    set(key.first, key.second, join(value, get(key.first, key.second)));
+  }
+  for (const auto &[key, value] : changedSince(entry)) {
+    if (!afterThen.count(key)) {
+      set(key.first, key.second, join(value, get(key.first, key.second)));
+    }
+  }
+
+  return {};
+}
+
+std::any TypeInference::visitWhileStmt(std::shared_ptr<While> stmt) {
+  // Iterate until the state at the loop head doesn't change anymore. The
+  // lattice has a finite height, so this always terminates.
+  while (true) {
+    std::size_t head = trail.size();
+    infer(stmt->getCondition());
+    Changes exit = currentSince(head);
+
+    analyze(stmt->getBody());
+    Changes next = changedSince(head);
+    bool changed = false;
+    for (auto &[key, value] : next) {
+      std::optional<Slot> joined = join(value, get(key.first, key.second));
+      changed = changed || joined != value;
+      value = std::move(joined);
+    }
+
+    undo(head);
+    for (const auto &[key, value] : changed ? next : exit) {
+      set(key.first, key.second, value);
+    }
+    if (!changed) {
+      break;
+    }
+  }
+  return {};
+}
+
+std::any TypeInference::visitVarStmt(std::shared_ptr<Var> stmt) {
+  InferredType type = stmt->getInitializer() ? infer(stmt->getInitializer())
+                                             : InferredType::NIL;
+
+  // The same declaration can be visited more than once inside a loop
+  auto [it, inserted] = declarationIds.try_emplace(
+      stmt.get(), static_cast<int>(declarations.size()));
+  if (inserted) {
+    declarations.push_back({std::string{stmt->getName().getLexeme()},
+                            stmt->getName().getLine(),
+                            InferredType::UNDEFINED});
+  }
+
+  Declaration &declaration = declarations[it->second];
+  declaration.type = join(declaration.type, type);
+  set(scopes.size() - 1, stmt->getName().getLexeme(), Slot{type, it->second});
+
+  return {};
+}
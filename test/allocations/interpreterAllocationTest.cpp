@@ -0,0 +1,71 @@
+#include "gsc/interpreter.hpp"
+#include "catch2/catch_amalgamated.hpp"
+#include "gsc/optimizer.hpp"
+#include "gsc/parser.hpp"
+#include "gsc/scanner.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+
+// Counts the heap allocations, which is why these tests are linked into
+// their own binary
+static std::size_t allocations = 0;
+
+void *operator new(std::size_t size) {
+  allocations++;
+  if (void *pointer = std::malloc(size ? size : 1)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+
+void operator delete(void *pointer, std::size_t) noexcept {
+  std::free(pointer);
+}
+
+TEST_CASE("Interpreting without copying strings",
+          "[interpreter][allocations]") {
+  auto countAllocations = [](const std::string &initial,
+                             const std::string &increment,
+                             OptimizationLevel level) {
+    std::string program =
+        "var s = " + initial + ";" +
+        "for (var i = 0; i < 1000; i = i + 1) s = s + " + increment + ";" +
+        "print s == s; print s;";
+    Scanner scanner{program};
+    scanner.scanTokens();
+    Parser parser{scanner.getTokens()};
+    std::vector<std::shared_ptr<Stmt>> statements =
+        Optimizer(level).optimize(parser.parse());
+    Interpreter interpreter;
+
+    std::ostringstream oss;
+    auto oldCout = std::cout.rdbuf(oss.rdbuf());
+    std::size_t before = allocations;
+    interpreter.interpret(statements);
+    std::size_t count = allocations - before;
+    std::cout.rdbuf(oldCout);
+
+    CHECK(oss.str().starts_with("true\n"));
+    return count;
+  };
+
+  // The same loop with numbers allocates as much as the loop itself does
+  for (OptimizationLevel level :
+       {OptimizationLevel::O0, OptimizationLevel::O1}) {
+    std::size_t loop = countAllocations("0", "1", level);
+    std::size_t strings =
+        countAllocations("\"\"", "\"some long text\"", level);
+
+    if (level == OptimizationLevel::O0) {
+      // Each iteration copies the string at least three times
+      CHECK(strings - loop >= 3000);
+    } else {
+      // Only the growth of the string allocates
+      CHECK(strings - loop < 100);
+    }
+  }
+}
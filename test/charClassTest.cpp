@@ -0,0 +1,40 @@
+#include "gsc/charClass.hpp"
+#include "catch2/catch_amalgamated.hpp"
+#include <cctype>
+
+TEST_CASE("Character classes", "[charClass]") {
+  SECTION("Every character matches the comparisons it replaced") {
+    for (int i = 0; i < 256; i++) {
+      char c = static_cast<char>(i);
+      INFO("Character " << i);
+      bool letter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+      CHECK(isDigit(c) == (c >= '0' && c <= '9'));
+      CHECK(isAlpha(c) == (letter || c == '_'));
+      CHECK(isAlphaNumeric(c) == (isAlpha(c) || isDigit(c)));
+      CHECK(isWhitespace(c) ==
+            (c == ' ' || c == '\t' || c == '\r' || c == '\n'));
+    }
+  }
+
+  SECTION("Single character tokens") {
+    CHECK(charClass('(') == CharClass::SINGLE);
+    CHECK(charTable['('].single == LEFT_PAREN);
+    CHECK(charTable['*'].single == STAR);
+    CHECK(charClass('"') == CharClass::QUOTE);
+    CHECK(charClass('/') == CharClass::SLASH);
+  }
+
+  SECTION("Operators followed by '='") {
+    CHECK(charClass('!') == CharClass::OPERATOR);
+    CHECK(charTable['!'].single == BANG);
+    CHECK(charTable['!'].withEqual == BANG_EQUAL);
+    CHECK(charTable['>'].single == GREATER);
+    CHECK(charTable['>'].withEqual == GREATER_EQUAL);
+  }
+
+  SECTION("Invalid characters") {
+    CHECK(charClass('@') == CharClass::INVALID);
+    CHECK(charClass('\0') == CharClass::INVALID);
+    CHECK(charClass(static_cast<char>(0xE9)) == CharClass::INVALID);
+  }
+}
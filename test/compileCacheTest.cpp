@@ -0,0 +1,133 @@
+#include "gsc/compileCache.hpp"
+#include "catch2/catch_amalgamated.hpp"
+#include "testHelpers.hpp"
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+/** Makes an entry older than the others, as if it wasn't used for a while. */
+void ageEntry(const std::filesystem::path &path, int hours) {
+  std::filesystem::last_write_time(
+      path, std::filesystem::file_time_type::clock::now() -
+                std::chrono::hours(hours));
+}
+
+} // namespace
+
+TEST_CASE("Caching parsed programs", "[compileCache]") {
+  std::filesystem::path directory =
+      std::filesystem::temp_directory_path() /
+      ("gscCacheTest-" + std::to_string(getpid()));
+  std::filesystem::remove_all(directory);
+
+  const std::string first = "var a = 1;\nprint a + 2;\n";
+  const std::string second = "print \"second\";\n";
+
+  SECTION("A stored program is loaded") {
+    CompileCache cache{directory};
+    CHECK_FALSE(cache.load(first));
+    cache.store(first, parse(first));
+
+    auto statements = cache.load(first);
+    REQUIRE(statements);
+    REQUIRE(statements->size() == 2);
+    auto declaration = std::dynamic_pointer_cast<Var>((*statements)[0]);
+    REQUIRE(declaration != nullptr);
+    CHECK(declaration->getName().getLexeme() == "a");
+
+    CompileCache::Statistics statistics = cache.getStatistics();
+    CHECK(statistics.hits == 1);
+    CHECK(statistics.misses == 1);
+    CHECK(statistics.entries == 1);
+    CHECK(statistics.size ==
+          std::filesystem::file_size(cache.entryPath(first)));
+  }
+
+  SECTION("The entries are keyed by the source code") {
+    CompileCache cache{directory};
+    CHECK(cache.entryPath(first) != cache.entryPath(second));
+    CHECK(cache.entryPath(first) == CompileCache{directory}.entryPath(first));
+
+    cache.store(first, parse(first));
+    CHECK_FALSE(cache.load(second));
+    CHECK_FALSE(cache.load(first + " "));
+  }
+
+  SECTION("An entry is only loaded for its own source") {
+    CompileCache cache{directory};
+    cache.store(first, parse(first));
+    std::filesystem::copy_file(cache.entryPath(first),
+                               cache.entryPath(second));
+
+    // As if the second program had the same key as the first one
+    CHECK_FALSE(cache.load(second));
+    cache.store(second, parse(second));
+    CHECK(cache.load(second));
+    CHECK(cache.load(first));
+  }
+
+  SECTION("Concurrent runs don't lose their counters") {
+    std::vector<std::thread> runs;
+    for (int i = 0; i < 4; i++) {
+      runs.emplace_back([&] {
+        CompileCache cache{directory};
+        for (int j = 0; j < 25; j++) {
+          cache.load(second);
+        }
+      });
+    }
+    for (std::thread &run : runs) {
+      run.join();
+    }
+    CHECK(CompileCache{directory}.getStatistics().misses == 100);
+  }
+
+  SECTION("Corrupted entries are removed") {
+    CompileCache cache{directory};
+    cache.store(first, parse(first));
+    std::filesystem::resize_file(cache.entryPath(first), 8);
+
+    CHECK_FALSE(cache.load(first));
+    CHECK_FALSE(std::filesystem::exists(cache.entryPath(first)));
+  }
+
+  SECTION("The least recently used entries are evicted") {
+    const std::string third = "print 3;\n";
+    CompileCache unbounded{directory};
+    unbounded.store(first, parse(first));
+    unbounded.store(second, parse(second));
+    ageEntry(unbounded.entryPath(first), 2);
+    ageEntry(unbounded.entryPath(second), 1);
+
+    // Using the oldest entry makes it the most recent one
+    CHECK(unbounded.load(first));
+    std::uintmax_t size = unbounded.getStatistics().size;
+
+    CompileCache cache{directory, size};
+    cache.store(third, parse(third));
+    CHECK(std::filesystem::exists(cache.entryPath(first)));
+    CHECK_FALSE(std::filesystem::exists(cache.entryPath(second)));
+    CHECK(std::filesystem::exists(cache.entryPath(third)));
+
+    CompileCache::Statistics statistics = cache.getStatistics();
+    CHECK(statistics.evictions == 1);
+    CHECK(statistics.entries == 2);
+    CHECK(statistics.size <= size);
+  }
+
+  SECTION("An unusable directory only disables the cache") {
+    std::filesystem::path file = directory.string() + ".file";
+    std::ofstream{file} << "not a directory";
+
+    CompileCache cache{file / "cache"};
+    cache.store(first, parse(first));
+    CHECK_FALSE(cache.load(first));
+    CHECK(cache.getStatistics().entries == 0);
+    std::filesystem::remove(file);
+  }
+
+  std::filesystem::remove_all(directory);
+}
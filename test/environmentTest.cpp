@@ -66,4 +66,17 @@ TEST_CASE("Environment with enclosing", "[environment][enclosing]") {
     Token name(TokenType::IDENTIFIER, "undefinedVar", "undefinedVar", 1);
     REQUIRE_THROWS_AS(env.assign(name, 42), RuntimeError);
   }
+
+  SECTION("Take variable from enclosing environment") {
+    Token name(TokenType::IDENTIFIER, "auxVar", "auxVar", 1);
+    std::any value = env.take(name);
+    REQUIRE(value.type() == typeid(int));
+    CHECK(std::any_cast<int>(value) == 10);
+    CHECK(env.get(name).type() == typeid(std::nullptr_t));
+  }
+
+  SECTION("Take undefined variable in enclosing environment") {
+    Token name(TokenType::IDENTIFIER, "undefinedVar", "undefinedVar", 1);
+    REQUIRE_THROWS_AS(env.take(name), RuntimeError);
+  }
 }
@@ -39,3 +39,38 @@ TEST_CASE("Error handling", "[error]") {
   // Restore the original cerr buffer
   std::cerr.rdbuf(oldCerr);
 }
+
+TEST_CASE("Collecting errors in a diagnostic list", "[error][diagnostic]") {
+  std::ostringstream oss;
+  auto oldCerr = std::cerr.rdbuf(oss.rdbuf());
+  DiagnosticList diagnostics{2};
+  diagnosticSink = &diagnostics;
+
+  hadError = false;
+  error(Token(TokenType::NUMBER, "2", 2, 1), "First error");
+  error(Token(TokenType::END_OF_FILE, "", nullptr, 3), "Second error");
+  error(4, "Third error");
+  error(Token(TokenType::NUMBER, "5", 5, 5), "Fourth error");
+
+  diagnosticSink = nullptr;
+  std::cerr.rdbuf(oldCerr);
+
+  CHECK(hadError);
+  hadError = false;
+  CHECK(oss.str().empty());
+  CHECK(diagnostics.isFull());
+  REQUIRE(diagnostics.getDiagnostics().size() == 2);
+  CHECK(diagnostics.getDropped() == 2);
+
+  const Diagnostic &first = diagnostics.getDiagnostics()[0];
+  CHECK(first.line == 1);
+  CHECK(first.where == "at '2'");
+  CHECK(first.message == "First error");
+  CHECK(diagnostics.getDiagnostics()[1].where == "at end");
+
+  std::ostringstream printed;
+  diagnostics.print(printed);
+  CHECK(printed.str() == "[line 1] Error at '2': First error\n"
+                         "[line 3] Error at end: Second error\n"
+                         "... and 2 more errors.\n");
+}
@@ -1,6 +1,9 @@
 #include "gsc/interpreter.hpp"
 #include "catch2/catch_amalgamated.hpp"
 #include "gsc/error.hpp"
+#include "gsc/optimizer.hpp"
+#include "gsc/parser.hpp"
+#include "gsc/scanner.hpp"
 #include <iostream>
 #include <memory>
 
@@ -761,3 +764,87 @@ TEST_CASE("Interpreting While Statement", "[interpreter][statement][while]") {
   // Restore the original cout buffer
   std::cout.rdbuf(oldCout);
 }
+
+TEST_CASE("Syntax errors in blocks are found before running",
+          "[interpreter][parser]") {
+  // Blocks are parsed eagerly by default, like the whole program
+  const std::string program = "print \"before\";\n"
+                              "if (true) { var q = 3 }\n";
+  std::ostringstream err;
+  auto oldCerr = std::cerr.rdbuf(err.rdbuf());
+  hadError = false;
+  Scanner scanner{program};
+  std::vector<std::shared_ptr<Stmt>> statements = Parser{scanner}.parse();
+  std::cerr.rdbuf(oldCerr);
+
+  // So the program stops before its first statement runs
+  REQUIRE(hadError);
+  hadError = false;
+  CHECK(err.str().starts_with(
+      "[line 2] Error at '}': Expect ';' after variable declaration.\n"));
+}
+
+TEST_CASE("Interpreting lazily parsed blocks", "[interpreter][lazy]") {
+  auto runLazily = [](const std::string &program, OptimizationLevel level) {
+    // The deferred blocks are parsed from the tokens while running
+    Scanner scanner{program};
+    scanner.scanTokens();
+    Parser parser{scanner.getTokens()};
+    parser.setLazyBlocks(true);
+    std::vector<std::shared_ptr<Stmt>> statements =
+        Optimizer(level).optimize(parser.parse());
+
+    std::ostringstream out;
+    auto oldCout = std::cout.rdbuf(out.rdbuf());
+    Interpreter().interpret(statements);
+    std::cout.rdbuf(oldCout);
+    return out.str();
+  };
+
+  std::ostringstream err;
+  auto oldCerr = std::cerr.rdbuf(err.rdbuf());
+  hadError = false;
+  hadRuntimeError = false;
+  OptimizationLevel level = GENERATE(OptimizationLevel::O0,
+                                     OptimizationLevel::O1,
+                                     OptimizationLevel::O2);
+
+  SECTION("Only the blocks that run are parsed") {
+    CHECK(runLazily("if (false) { print 1 +; } else { print 2; }", level) ==
+          "2\n");
+    CHECK_FALSE(hadError);
+    CHECK_FALSE(hadRuntimeError);
+  }
+
+  SECTION("Syntax errors stop the program when their block runs") {
+    CHECK(runLazily("print 1;\nif (true) {\n  print 2 +;\n}\nprint 3;",
+                    level) == "1\n");
+    CHECK(hadError);
+    CHECK(hadRuntimeError);
+    CHECK(err.str() == "[line 3] Error at ';': Expect expression.\n"
+                       "Syntax error in block.\n[line 2]\n");
+  }
+
+  SECTION("Values read by a deferred block aren't released before it") {
+    CHECK(runLazily("var a = \"value\";\nvar b = a;\n"
+                    "if (b == \"value\") { print a; }",
+                    level) == "value\n");
+  }
+
+  SECTION("Types assigned in a deferred block are unknown after it") {
+    CHECK(runLazily("var s = \"x\";\nif (true) { s = 1; }\nprint s + s;",
+                    level) == "2\n");
+  }
+
+  SECTION("Loops with deferred bodies run as parsed") {
+    CHECK(runLazily("var a = 0;\n"
+                    "for (var i = 0; i < 3; i = i + 1) { a = a + i; }\n"
+                    "for (var i = 0; i < 3; i = i + 1) { i = i + 1; }\n"
+                    "print a;",
+                    level) == "3\n");
+  }
+
+  std::cerr.rdbuf(oldCerr);
+  hadError = false;
+  hadRuntimeError = false;
+}
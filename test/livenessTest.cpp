@@ -0,0 +1,109 @@
+#include "gsc/liveness.hpp"
+#include "catch2/catch_amalgamated.hpp"
+#include "gsc/optimizer.hpp"
+#include "testHelpers.hpp"
+
+namespace {
+
+std::shared_ptr<Variable> printedVariable(const std::shared_ptr<Stmt> &stmt) {
+  std::shared_ptr<Print> print = std::dynamic_pointer_cast<Print>(stmt);
+  REQUIRE(print != nullptr);
+  std::shared_ptr<Variable> variable =
+      std::dynamic_pointer_cast<Variable>(print->getExpression());
+  REQUIRE(variable != nullptr);
+  return variable;
+}
+
+} // namespace
+
+TEST_CASE("Last uses", "[liveness][lastUse]") {
+  SECTION("Only the last read of a variable") {
+    std::vector<std::shared_ptr<Stmt>> statements =
+        parse("var a = 1; print a; print a;");
+    Liveness liveness;
+    liveness.analyze(statements);
+
+    CHECK_FALSE(printedVariable(statements[1])->isLastUse());
+    CHECK(printedVariable(statements[2])->isLastUse());
+    CHECK(liveness.getLastUses() == 1);
+  }
+
+  SECTION("Reads in both branches of an if") {
+    std::vector<std::shared_ptr<Stmt>> statements = parse(
+        "var a = 1; if (true) print a; else print a;");
+    Liveness().analyze(statements);
+    std::shared_ptr<If> ifStmt = std::dynamic_pointer_cast<If>(statements[1]);
+
+    CHECK(printedVariable(ifStmt->getThenBranch())->isLastUse());
+    CHECK(printedVariable(ifStmt->getElseBranch())->isLastUse());
+  }
+
+  SECTION("Reads inside a loop are live in the next iteration") {
+    std::vector<std::shared_ptr<Stmt>> statements = parse(
+        "var a = 1; var i = 0; while (i < 3) { print a; i = i + 1; }");
+    Liveness().analyze(statements);
+    std::shared_ptr<While> loop =
+        std::dynamic_pointer_cast<While>(statements[2]);
+    std::shared_ptr<Block> body =
+        std::dynamic_pointer_cast<Block>(loop->getBody());
+
+    CHECK_FALSE(printedVariable(body->getStatements()[0])->isLastUse());
+  }
+
+  SECTION("Global variables are kept when it's not the whole program") {
+    std::vector<std::shared_ptr<Stmt>> statements =
+        parse("var a = 1; print a; { var b = 2; print b; }");
+    Liveness liveness{false};
+    liveness.analyze(statements);
+    std::shared_ptr<Block> block =
+        std::dynamic_pointer_cast<Block>(statements[2]);
+
+    CHECK_FALSE(printedVariable(statements[1])->isLastUse());
+    CHECK(printedVariable(block->getStatements()[1])->isLastUse());
+  }
+
+  SECTION("Undeclared variables are never released") {
+    std::vector<std::shared_ptr<Stmt>> statements = parse("print a;");
+    Liveness liveness;
+    liveness.analyze(statements);
+
+    CHECK_FALSE(printedVariable(statements[0])->isLastUse());
+    CHECK(liveness.getLastUses() == 0);
+  }
+}
+
+TEST_CASE("Dead stores", "[liveness][deadStore]") {
+  std::vector<std::shared_ptr<Stmt>> statements =
+      parse("var a = 1; a = 2; print a; a = 3;");
+  Liveness liveness;
+  liveness.analyze(statements);
+
+  auto assignment = [&](int index) {
+    std::shared_ptr<Expression> stmt =
+        std::dynamic_pointer_cast<Expression>(statements[index]);
+    REQUIRE(stmt != nullptr);
+    return std::dynamic_pointer_cast<Assign>(stmt->getExpression());
+  };
+
+  CHECK(std::dynamic_pointer_cast<Var>(statements[0])->isDeadStore());
+  CHECK_FALSE(assignment(1)->isDeadStore());
+  CHECK(assignment(3)->isDeadStore());
+  CHECK(liveness.getDeadStores() == 2);
+}
+
+TEST_CASE("Releasing dead values keeps the output", "[liveness][output]") {
+  std::string program = GENERATE(
+      "var s = \"\"; for (var i = 0; i < 5; i = i + 1) s = s + \"x\";"
+      "print s;",
+      "var a = \"a\"; var b = a + a; print b; print a;",
+      "var a = 1; { var a = 2; print a; } print a;",
+      "var a = 1; var a = a + 1; print a;",
+      "var a = \"x\"; print a == a; print a or a;",
+      "var a = 0; while (a < 3) { var b = a; a = b + 1; print b; }");
+
+  std::vector<std::shared_ptr<Stmt>> original = parse(program);
+  std::vector<std::shared_ptr<Stmt>> optimized = parse(program);
+  Optimizer(OptimizationLevel::O2).optimize(optimized);
+
+  CHECK(interpretCapturing(optimized) == interpretCapturing(original));
+}
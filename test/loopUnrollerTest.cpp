@@ -0,0 +1,145 @@
+#include "gsc/loopUnroller.hpp"
+#include "catch2/catch_amalgamated.hpp"
+#include "testHelpers.hpp"
+
+namespace {
+
+std::vector<std::shared_ptr<Stmt>>
+loopStatements(const std::vector<std::shared_ptr<Stmt>> &statements) {
+  REQUIRE(statements.size() == 1);
+  std::shared_ptr<Block> block =
+      std::dynamic_pointer_cast<Block>(statements[0]);
+  REQUIRE(block != nullptr);
+  return block->getStatements();
+}
+
+int countLoops(const std::vector<std::shared_ptr<Stmt>> &statements) {
+  int loops = 0;
+  for (const std::shared_ptr<Stmt> &stmt : statements) {
+    loops += std::dynamic_pointer_cast<While>(stmt) != nullptr;
+  }
+  return loops;
+}
+
+} // namespace
+
+TEST_CASE("Unrolling counted loops", "[loopUnroller][unroll]") {
+  LoopUnroller unroller{4, 256};
+
+  SECTION("Fully unrolled loop") {
+    std::vector<std::shared_ptr<Stmt>> statements =
+        parse("for (var i = 0; i < 3; i = i + 1) print i;");
+    std::vector<std::shared_ptr<Stmt>> unrolled = unroller.unroll(statements);
+
+    CHECK(unroller.getUnrolledLoops() == 1);
+    // var i = 0; (print i; i = i + 1;) x 3
+    std::vector<std::shared_ptr<Stmt>> body = loopStatements(unrolled);
+    CHECK(body.size() == 7);
+    CHECK(countLoops(body) == 0);
+    CHECK(interpretCapturing(unrolled) == "0\n1\n2\n");
+  }
+
+  SECTION("Partially unrolled loop") {
+    std::vector<std::shared_ptr<Stmt>> statements =
+        parse("for (var i = 0; i < 10; i = i + 1) print i;");
+    std::vector<std::shared_ptr<Stmt>> unrolled = unroller.unroll(statements);
+
+    CHECK(unroller.getUnrolledLoops() == 1);
+    // var i = 0; (print i; i = i + 1;) x 2; while (i < 10) { ... x 4 }
+    std::vector<std::shared_ptr<Stmt>> body = loopStatements(unrolled);
+    REQUIRE(body.size() == 6);
+    std::shared_ptr<While> loop = std::dynamic_pointer_cast<While>(body[5]);
+    REQUIRE(loop != nullptr);
+    std::shared_ptr<Block> loopBody =
+        std::dynamic_pointer_cast<Block>(loop->getBody());
+    REQUIRE(loopBody != nullptr);
+    CHECK(loopBody->getStatements().size() == 8);
+    CHECK(interpretCapturing(unrolled) == interpretCapturing(statements));
+  }
+
+  SECTION("Descending loop with a bigger step") {
+    std::vector<std::shared_ptr<Stmt>> statements =
+        parse("for (var i = 10; i >= -1; i = i - 3) print i;");
+    std::vector<std::shared_ptr<Stmt>> unrolled = unroller.unroll(statements);
+
+    CHECK(unroller.getUnrolledLoops() == 1);
+    CHECK(interpretCapturing(unrolled) == "10\n7\n4\n1\n");
+  }
+
+  SECTION("Declarations in the body keep their scope") {
+    std::vector<std::shared_ptr<Stmt>> statements = parse(
+        "var t = \"outer\";"
+        "for (var i = 0; i < 6; i = i + 1) { var t = i * 2; print t; }"
+        "print t;");
+    std::vector<std::shared_ptr<Stmt>> unrolled = unroller.unroll(statements);
+
+    CHECK(unroller.getUnrolledLoops() == 1);
+    CHECK(interpretCapturing(unrolled) == "0\n2\n4\n6\n8\n10\nouter\n");
+  }
+
+  SECTION("Nested loops") {
+    std::vector<std::shared_ptr<Stmt>> statements =
+        parse("for (var i = 0; i < 2; i = i + 1)"
+              "  for (var j = 0; j < 2; j = j + 1)"
+              "    print i * 10 + j;");
+    std::vector<std::shared_ptr<Stmt>> unrolled = unroller.unroll(statements);
+
+    CHECK(unroller.getUnrolledLoops() == 2);
+    CHECK(interpretCapturing(unrolled) == "0\n1\n10\n11\n");
+  }
+
+  SECTION("Original program isn't modified") {
+    std::vector<std::shared_ptr<Stmt>> statements =
+        parse("for (var i = 0; i < 3; i = i + 1) print i;");
+    unroller.unroll(statements);
+
+    CHECK(countLoops(loopStatements(statements)) == 1);
+  }
+}
+
+TEST_CASE("Loops that aren't unrolled", "[loopUnroller][skip]") {
+  LoopUnroller unroller{4, 256};
+
+  SECTION("Induction variable assigned in the body") {
+    std::vector<std::shared_ptr<Stmt>> statements = parse(
+        "for (var i = 0; i < 8; i = i + 1) { print i; i = i + 1; }");
+    std::vector<std::shared_ptr<Stmt>> unrolled = unroller.unroll(statements);
+
+    CHECK(unroller.getUnrolledLoops() == 0);
+    CHECK(interpretCapturing(unrolled) == "0\n2\n4\n6\n");
+  }
+
+  SECTION("Non-constant bound") {
+    std::vector<std::shared_ptr<Stmt>> statements = parse(
+        "var n = 3; for (var i = 0; i < n; i = i + 1) print i;");
+    unroller.unroll(statements);
+    CHECK(unroller.getUnrolledLoops() == 0);
+  }
+
+  SECTION("Loop that never ends") {
+    std::vector<std::shared_ptr<Stmt>> statements =
+        parse("for (var i = 0; i < 8; i = i - 1) print i;");
+    unroller.unroll(statements);
+    CHECK(unroller.getUnrolledLoops() == 0);
+  }
+
+  SECTION("Loop that never runs") {
+    std::vector<std::shared_ptr<Stmt>> statements =
+        parse("for (var i = 8; i < 8; i = i + 1) print i;");
+    unroller.unroll(statements);
+    CHECK(unroller.getUnrolledLoops() == 0);
+  }
+
+  SECTION("Code growth over the budget") {
+    LoopUnroller smallBudget{4, 25};
+    std::vector<std::shared_ptr<Stmt>> statements =
+        parse("for (var i = 0; i < 4; i = i + 1) print i;"
+              "for (var i = 0; i < 4; i = i + 1) print i;");
+    std::vector<std::shared_ptr<Stmt>> unrolled =
+        smallBudget.unroll(statements);
+
+    // Only the first loop fits in the budget
+    CHECK(smallBudget.getUnrolledLoops() == 1);
+    CHECK(interpretCapturing(unrolled) == "0\n1\n2\n3\n0\n1\n2\n3\n");
+  }
+}
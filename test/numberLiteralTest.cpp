@@ -0,0 +1,65 @@
+#include "gsc/numberLiteral.hpp"
+#include "catch2/catch_amalgamated.hpp"
+#include <charconv>
+#include <string>
+
+/** Parses a number with std::from_chars, as a reference. */
+template <class T> std::optional<T> referenceNumber(std::string_view digits) {
+  T value = 0;
+  auto [end, error] =
+      std::from_chars(digits.data(), digits.data() + digits.size(), value);
+  if (error != std::errc{}) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+TEST_CASE("Number literals", "[numberLiteral]") {
+  SECTION("Every length and the limits of int") {
+    std::string digits = GENERATE(
+        "0", "7", "42", "123", "1234", "12345", "123456", "1234567",
+        "12345678", "123456789", "1234567890", "000000000000000001",
+        "99999999", "100000000", "2147483647", "2147483648", "4294967296",
+        "02147483647", "99999999999", "123456781234567812345678");
+
+    CHECK(parseNumber(digits) == referenceNumber<int>(digits));
+  }
+
+  SECTION("Random numbers") {
+    auto number = GENERATE(take(200, random(0, 2147483647)));
+    std::string digits = std::to_string(number);
+
+    CHECK(parseNumber(digits) == number);
+  }
+
+  SECTION("Wider integers") {
+    std::string digits = GENERATE("2147483648", "9223372036854775807",
+                                  "9223372036854775808",
+                                  "18446744073709551616");
+
+    CHECK(parseNumber<long long>(digits) == referenceNumber<long long>(digits));
+  }
+}
+
+TEST_CASE("Number literal throughput", "[.benchmark][numberLiteral]") {
+  std::vector<std::string> literals;
+  for (int i = 0; i < 1000; i++) {
+    literals.push_back(std::to_string(i * 2147483));
+  }
+
+  BENCHMARK("std::stoi") {
+    long total = 0;
+    for (const std::string &literal : literals) {
+      total += std::stoi(literal);
+    }
+    return total;
+  };
+
+  BENCHMARK("parseNumber") {
+    long total = 0;
+    for (const std::string &literal : literals) {
+      total += *parseNumber(literal);
+    }
+    return total;
+  };
+}
@@ -0,0 +1,140 @@
+#include "gsc/optimizer.hpp"
+#include "catch2/catch_amalgamated.hpp"
+#include "gsc/liveness.hpp"
+#include "gsc/typeInference.hpp"
+#include "testHelpers.hpp"
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+namespace {
+
+/** Pass that only records that it was run. */
+class RecordingPass : public Pass {
+private:
+  std::vector<std::string> &log;
+
+public:
+  RecordingPass(std::vector<std::string> &log) : log(log) {}
+
+  std::string getName() const override { return "recording"; }
+
+  std::vector<std::shared_ptr<Stmt>>
+  run(const std::vector<std::shared_ptr<Stmt>> &statements) override {
+    log.push_back("run with " + std::to_string(statements.size()));
+    return statements;
+  }
+};
+
+/** Generates a program that declares a global per three lines, and then
+ * branches, loops and short-circuits over them. */
+std::string generateBranchingSource(int lines) {
+  int globals = lines / 3;
+  std::string source;
+  for (int i = 0; i < globals; i++) {
+    source += "var v" + std::to_string(i) + " = " + std::to_string(i) + ";\n";
+  }
+  for (int i = 0; i < lines - globals; i++) {
+    std::string v = "v" + std::to_string(i % globals);
+    std::string c = "c" + std::to_string(i);
+    switch (i % 3) {
+    case 0:
+      source += "if (" + v + " < 3) " + v + " = " + v + " + 1; else print " +
+                v + ";\n";
+      break;
+    case 1:
+      source += "var " + c + " = 0; while (" + c + " < 2 and " + v + " > 0) " +
+                c + " = " + c + " + 1;\n";
+      break;
+    default:
+      source += "print " + v + " < 2 or " + v + " > 5;\n";
+    }
+  }
+  return source;
+}
+
+/** Returns the best time of a few runs of a pass on a generated program. */
+template <class Analysis> double analysisSeconds(int lines) {
+  std::string source = generateBranchingSource(lines);
+  std::vector<std::shared_ptr<Stmt>> statements = parse(source);
+
+  double best = 0;
+  for (int i = 0; i < 3; i++) {
+    auto start = std::chrono::steady_clock::now();
+    Analysis().analyze(statements);
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best = i == 0 ? elapsed.count() : std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+} // namespace
+
+TEST_CASE("Passes of each optimization level", "[optimizer][levels]") {
+  SECTION("O0") {
+    CHECK(Optimizer(OptimizationLevel::O0).getPassNames().empty());
+  }
+
+  SECTION("O1") {
+    CHECK(Optimizer(OptimizationLevel::O1).getPassNames() ==
+          std::vector<std::string>{"type-inference", "liveness"});
+  }
+
+  SECTION("O2") {
+    CHECK(Optimizer(OptimizationLevel::O2).getPassNames() ==
+          std::vector<std::string>{"loop-unrolling", "type-inference",
+                                   "liveness"});
+  }
+}
+
+TEST_CASE("Running the pipeline", "[optimizer][pipeline]") {
+  std::vector<std::shared_ptr<Stmt>> statements =
+      parse("var s = 0;"
+            "for (var i = 0; i < 10; i = i + 1) s = s + i;"
+            "print s;");
+
+  SECTION("Same output in every level") {
+    for (OptimizationLevel level :
+         {OptimizationLevel::O0, OptimizationLevel::O1,
+          OptimizationLevel::O2}) {
+      CHECK(interpretCapturing(Optimizer(level).optimize(statements)) ==
+            "45\n");
+    }
+  }
+
+  SECTION("Custom passes run after the default ones") {
+    std::vector<std::string> log;
+    Optimizer optimizer{OptimizationLevel::O0};
+    optimizer.addPass(std::make_unique<RecordingPass>(log));
+    optimizer.addPass(std::make_unique<RecordingPass>(log));
+    optimizer.optimize(statements);
+
+    CHECK(log == std::vector<std::string>{"run with 3", "run with 3"});
+  }
+
+  SECTION("Timing output") {
+    std::ostringstream timings;
+    Optimizer optimizer{OptimizationLevel::O2};
+    optimizer.setTimingOutput(&timings);
+    optimizer.optimize(statements);
+
+    CHECK(timings.str().starts_with("[pass] loop-unrolling: "));
+    CHECK(timings.str().find("\n[pass] type-inference: ") !=
+          std::string::npos);
+  }
+}
+
+TEST_CASE("Analyses grow linearly with the program", "[optimizer][scaling]") {
+  // Copying the whole state at each branch makes 4x the lines take 16x the
+  // time, so a linear pass stays well below 10x
+  SECTION("Type inference") {
+    CHECK(analysisSeconds<TypeInference>(8000) <
+          10 * analysisSeconds<TypeInference>(2000));
+  }
+
+  SECTION("Liveness") {
+    CHECK(analysisSeconds<Liveness>(8000) <
+          10 * analysisSeconds<Liveness>(2000));
+  }
+}
@@ -1,9 +1,19 @@
 #include "gsc/parser.hpp"
 #include "catch2/catch_amalgamated.hpp"
+#include "gsc/error.hpp"
 #include "gsc/expr.hpp"
+#include "gsc/interpreter.hpp"
+#include "gsc/scanner.hpp"
+#include "gsc/serializer.hpp"
 #include "gsc/stmt.hpp"
+#include "testHelpers.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <iostream>
 #include <memory>
+#include <thread>
+#include <typeinfo>
 
 TEST_CASE("Parse an empty program", "[parser][program][empty]") {
   // Hide the error output
@@ -904,7 +914,7 @@ TEST_CASE("Parsing declaring statements", "[parser][statement][declare]") {
         std::dynamic_pointer_cast<Var>(statements[0]);
 
     REQUIRE(varStmt->getName().getType() == TokenType::IDENTIFIER);
-    std::string varName = varStmt->getName().getLexeme();
+    std::string varName{varStmt->getName().getLexeme()};
     CHECK(varName == "x");
 
     REQUIRE(varStmt->getInitializer() == nullptr);
@@ -923,7 +933,7 @@ TEST_CASE("Parsing declaring statements", "[parser][statement][declare]") {
         std::dynamic_pointer_cast<Var>(statements[0]);
 
     REQUIRE(varStmt->getName().getType() == TokenType::IDENTIFIER);
-    std::string varName = varStmt->getName().getLexeme();
+    std::string varName{varStmt->getName().getLexeme()};
     CHECK(varName == "x");
 
     REQUIRE(varStmt->getInitializer() != nullptr);
@@ -1530,3 +1540,686 @@ TEST_CASE("Parsing and desugaring for statement", "[parser][statement][for]") {
     CHECK(std::any_cast<int>(rightLiteral2->getValue()) == 1);
   }
 }
+
+TEST_CASE("Parse tokens pulled from the scanner", "[parser][stream]") {
+  auto interpretParsed = [](const std::vector<std::shared_ptr<Stmt>> &stmts) {
+    std::ostringstream oss;
+    auto oldCout = std::cout.rdbuf(oss.rdbuf());
+    Interpreter().interpret(stmts);
+    std::cout.rdbuf(oldCout);
+    return oss.str();
+  };
+
+  SECTION("Same program as parsing all the tokens") {
+    std::string_view program = "var total = 0;"
+                               "for (var i = 0; i < 5; i = i + 1) {"
+                               "  if (i == 2 or i == 4) total = total + i;"
+                               "  else { print -i; }"
+                               "}"
+                               "print total;";
+    Scanner reference{program};
+    reference.scanTokens();
+    std::vector<std::shared_ptr<Stmt>> expected =
+        Parser(reference.getTokens()).parse();
+
+    Scanner scanner{program};
+    std::vector<std::shared_ptr<Stmt>> statements = Parser(scanner).parse();
+
+    REQUIRE(statements.size() == expected.size());
+    CHECK(interpretParsed(statements) == interpretParsed(expected));
+  }
+
+  SECTION("Empty program") {
+    Scanner scanner{""};
+    CHECK(Parser(scanner).parse().empty());
+  }
+
+  SECTION("Errors are recovered in the same way") {
+    std::ostringstream oss;
+    auto oldCerr = std::cerr.rdbuf(oss.rdbuf());
+
+    Scanner scanner{"print 1; var = 2; print 3; print (4;"};
+    std::vector<std::shared_ptr<Stmt>> statements = Parser(scanner).parse();
+    std::cerr.rdbuf(oldCerr);
+
+    CHECK(hadError);
+    hadError = false;
+    CHECK(oss.str().find("Expect variable name.") != std::string::npos);
+    CHECK(oss.str().find("at end") == std::string::npos);
+  }
+}
+
+/** Generates a program with the given number of statements, mixing
+ * declarations, conditionals, loops and expressions. */
+std::string generateParserSource(int statements) {
+  const std::array<std::string_view, 4> lines = {
+      "var v = (1 + 2) * 3 - 4 / 5;\n",
+      "if (a >= 10 and b != nil) print \"text\"; else a = a + 1;\n",
+      "while (i < 10) { i = i + 1; }\n",
+      "print !true == false or x <= -y;\n",
+  };
+
+  std::string source;
+  for (int i = 0; i < statements; i++) {
+    source += lines[i % lines.size()];
+  }
+  return source;
+}
+
+TEST_CASE("Parser throughput in tokens/s", "[.benchmark][parser]") {
+  std::string source = generateParserSource(1000000);
+  Scanner scanner{source};
+  scanner.scanTokens();
+  std::span<const Token> tokens = scanner.getTokens();
+
+  double best = 0;
+  for (int i = 0; i < 3; i++) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::shared_ptr<Stmt>> statements = Parser{tokens}.parse();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    REQUIRE(statements.size() == 1000000);
+    best = std::max(best, tokens.size() / elapsed.count());
+  }
+  WARN("Parsing 1M statements: " << best << " tokens/s");
+}
+
+/** Writes an expression in prefix notation, with its operators grouped. */
+std::string renderParsedExpr(const std::shared_ptr<Expr> &expr) {
+  if (auto binary = std::dynamic_pointer_cast<Binary>(expr)) {
+    return "(" + std::string{binary->getOp().getLexeme()} + " " +
+           renderParsedExpr(binary->getLeft()) + " " +
+           renderParsedExpr(binary->getRight()) + ")";
+  } else if (auto logical = std::dynamic_pointer_cast<Logical>(expr)) {
+    return "(" + std::string{logical->getOp().getLexeme()} + " " +
+           renderParsedExpr(logical->getLeft()) + " " +
+           renderParsedExpr(logical->getRight()) + ")";
+  } else if (auto unary = std::dynamic_pointer_cast<Unary>(expr)) {
+    return "(" + std::string{unary->getOp().getLexeme()} + " " +
+           renderParsedExpr(unary->getRight()) + ")";
+  } else if (auto assign = std::dynamic_pointer_cast<Assign>(expr)) {
+    return "(= " + std::string{assign->getName().getLexeme()} + " " +
+           renderParsedExpr(assign->getValue()) + ")";
+  } else if (auto grouping = std::dynamic_pointer_cast<Grouping>(expr)) {
+    return "(group " + renderParsedExpr(grouping->getExpression()) + ")";
+  } else if (auto variable = std::dynamic_pointer_cast<Variable>(expr)) {
+    return std::string{variable->getName().getLexeme()};
+  }
+
+  const std::any &value = std::dynamic_pointer_cast<Literal>(expr)->getValue();
+  if (const int *number = std::any_cast<int>(&value)) {
+    return std::to_string(*number);
+  } else if (const bool *boolean = std::any_cast<bool>(&value)) {
+    return *boolean ? "true" : "false";
+  } else if (const std::string *text = std::any_cast<std::string>(&value)) {
+    return "\"" + *text + "\"";
+  }
+  return "nil";
+}
+
+TEST_CASE("Operator precedence and associativity", "[parser][precedence]") {
+  auto [program, expected] =
+      GENERATE(table<std::string, std::string>({
+          {"1 - 2 - 3;", "(- (- 1 2) 3)"},
+          {"8 / 4 * 2;", "(* (/ 8 4) 2)"},
+          {"a or b and c == d < e + f * -g;",
+           "(or a (and b (== c (< d (+ e (* f (- g)))))))"},
+          {"1 * 2 + 3 / 4 >= 5 != true;",
+           "(!= (>= (+ (* 1 2) (/ 3 4)) 5) true)"},
+          {"a = b = c or d;", "(= a (= b (or c d)))"},
+          {"!!a == (b or nil);", "(== (! (! a)) (group (or b nil)))"},
+          {"a or b or c and d and e;", "(or (or a b) (and (and c d) e))"},
+          {"-(1 + 2) * \"s\" <= 3;", "(<= (* (- (group (+ 1 2))) \"s\") 3)"},
+      }));
+
+  Scanner scanner{program};
+  std::vector<std::shared_ptr<Stmt>> statements = Parser{scanner}.parse();
+  REQUIRE(statements.size() == 1);
+  std::shared_ptr<Expression> statement =
+      std::dynamic_pointer_cast<Expression>(statements[0]);
+  REQUIRE(statement != nullptr);
+
+  CHECK(renderParsedExpr(statement->getExpression()) == expected);
+}
+
+TEST_CASE("Deeply nested programs", "[parser][depth]") {
+  auto parseNested = [](const std::string &program, int maxDepth) {
+    std::ostringstream oss;
+    auto oldCerr = std::cerr.rdbuf(oss.rdbuf());
+    Scanner scanner{program};
+    Parser parser{scanner};
+    parser.setMaxDepth(maxDepth);
+    parser.parse();
+    std::cerr.rdbuf(oldCerr);
+    return oss.str();
+  };
+  auto repeat = [](std::string_view text, int times) {
+    std::string result;
+    for (int i = 0; i < times; i++) {
+      result += text;
+    }
+    return result;
+  };
+
+  SECTION("Pathological inputs are reported once instead of crashing") {
+    const int n = 100000;
+    std::string program = GENERATE_COPY(
+        "print " + repeat("(", n) + "1" + repeat(")", n) + ";",
+        "print 1" + repeat(" + 1", n) + ";",
+        "print " + repeat("-", n) + "1;",
+        "var a; " + repeat("a = ", n) + "1;",
+        repeat("{", n) + "print 1;" + repeat("}", n),
+        repeat("while (true) ", n) + "print 1;");
+
+    hadError = false;
+    std::string errors = parseNested(program, Parser::DEFAULT_MAX_DEPTH);
+    CHECK(hadError);
+    hadError = false;
+    CHECK(errors.find("nested too deeply.") != std::string::npos);
+    CHECK(std::count(errors.begin(), errors.end(), '\n') == 1);
+  }
+
+  SECTION("Programs at the limit are parsed") {
+    const int operators = 5 * Parser::OPERATORS_PER_LEVEL;
+    std::string program =
+        GENERATE_COPY("print " + repeat("(", 5) + "1" + repeat(")", 5) + ";",
+                      "print 1" + repeat(" + 1", operators) + ";",
+                      repeat("{", 5) + repeat("}", 5));
+
+    hadError = false;
+    CHECK(parseNested(program, 8).empty());
+    CHECK_FALSE(hadError);
+    CHECK_FALSE(parseNested(program, 4).empty());
+    hadError = false;
+  }
+}
+
+TEST_CASE("Long chains of operators", "[parser][depth]") {
+  // The chain is parsed in a loop, so it's much longer than the depth
+  const int n = 4 * Parser::DEFAULT_MAX_DEPTH;
+  std::string program = "var a = 1;\nprint a";
+  for (int i = 0; i < n; i++) {
+    program += " + a";
+  }
+  program += ";\n";
+
+  hadError = false;
+  std::vector<std::shared_ptr<Stmt>> statements = parse(program);
+  REQUIRE_FALSE(hadError);
+  CHECK(interpretCapturing(statements) == std::to_string(n + 1) + "\n");
+  // And it can be serialized
+  std::string data = Serializer{}.serialize(statements);
+  CHECK(interpretCapturing(deserialize(data)) == std::to_string(n + 1) + "\n");
+}
+
+TEST_CASE("Programs with many errors", "[parser][diagnostic]") {
+  // Every other statement is broken, in a different way each time
+  std::array<std::string_view, 4> broken = {"print ;\n", "var = 1;\n",
+                                            "1 = 2;\n", "(1 + 2;\n"};
+  const int n = 10000;
+  std::string source;
+  for (int i = 0; i < n; i++) {
+    source += broken[i % broken.size()];
+    source += "print 1;\n";
+  }
+
+  DiagnosticList diagnostics;
+  diagnosticSink = &diagnostics;
+  hadError = false;
+  Scanner scanner{source};
+  std::vector<std::shared_ptr<Stmt>> statements;
+  CHECK_NOTHROW(statements = Parser{scanner}.parse());
+  diagnosticSink = nullptr;
+
+  CHECK(hadError);
+  hadError = false;
+  REQUIRE(statements.size() == 2 * n);
+  CHECK(std::count(statements.begin(), statements.end(), nullptr) == n);
+  CHECK(std::dynamic_pointer_cast<Print>(statements.back()) != nullptr);
+
+  REQUIRE(diagnostics.getDiagnostics().size() == DiagnosticList::DEFAULT_LIMIT);
+  CHECK(diagnostics.getDropped() == n - DiagnosticList::DEFAULT_LIMIT);
+  std::array<std::string_view, 4> expected = {
+      "Expect expression.", "Expect variable name.",
+      "Invalid assignment target.", "Expect ')' after expression."};
+  for (std::size_t i = 0; i < broken.size(); i++) {
+    const Diagnostic &diagnostic = diagnostics.getDiagnostics()[i];
+    CHECK(diagnostic.line == static_cast<int>(2 * i + 1));
+    CHECK(diagnostic.message == expected[i]);
+  }
+}
+
+TEST_CASE("Errors are reported in the same order when pulling tokens",
+          "[parser][diagnostic]") {
+  const std::string source = "print 1 +;\nprint 2;\nprint @;\n";
+  auto errorLines = [&](bool pull) {
+    DiagnosticList diagnostics;
+    diagnosticSink = &diagnostics;
+    Scanner scanner{source};
+    if (pull) {
+      Parser{scanner}.parse();
+    } else {
+      scanner.scanTokens();
+      Parser{scanner.getTokens()}.parse();
+    }
+    diagnosticSink = nullptr;
+
+    std::vector<int> lines;
+    for (const Diagnostic &diagnostic : diagnostics.getDiagnostics()) {
+      lines.push_back(diagnostic.line);
+    }
+    return lines;
+  };
+
+  hadError = false;
+  // The errors of the Scanner come first
+  CHECK(errorLines(false) == std::vector<int>{3, 1, 3});
+  CHECK(errorLines(true) == std::vector<int>{3, 1, 3});
+  CHECK(hadError);
+  hadError = false;
+}
+
+TEST_CASE("Parsing programs with many errors in tokens/s",
+          "[.benchmark][parser][diagnostic]") {
+  std::string valid = generateParserSource(1000000);
+  std::string broken;
+  for (int i = 0; i < 250000; i++) {
+    broken += "print ;\nvar = 1;\n1 = 2;\n(1 + 2;\n";
+  }
+
+  for (const std::string *source : {&valid, &broken}) {
+    Scanner scanner{*source};
+    scanner.scanTokens();
+    std::span<const Token> tokens = scanner.getTokens();
+
+    DiagnosticList diagnostics;
+    diagnosticSink = &diagnostics;
+    double best = 0;
+    for (int i = 0; i < 3; i++) {
+      auto start = std::chrono::steady_clock::now();
+      Parser{tokens}.parse();
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      best = std::max(best, tokens.size() / elapsed.count());
+    }
+    diagnosticSink = nullptr;
+    hadError = false;
+    WARN((source == &valid ? "Valid" : "Broken")
+         << " program: " << best << " tokens/s");
+  }
+}
+
+TEST_CASE("Parsing on several threads", "[parser][threads]") {
+  auto parseOnThreads = [](const std::string &source, unsigned threads,
+                           DiagnosticList &diagnostics) {
+    Scanner scanner{source};
+    scanner.scanTokens(1);
+    diagnosticSink = &diagnostics;
+    std::vector<std::shared_ptr<Stmt>> statements =
+        Parser{scanner.getTokens()}.parse(threads, 64);
+    diagnosticSink = nullptr;
+    return statements;
+  };
+
+  SECTION("The statements are the same as on a single thread") {
+    std::string source;
+    for (int i = 0; i < 200; i++) {
+      source += generateParserSource(4);
+      source += "{ var c = 1; { print c; } }\n";
+      source += "for (var i = 0; i < 3; i = i + 1) print i;\n";
+      source += "if (a) if (b) print 1; else print 2; else { print 3; }\n";
+    }
+
+    hadError = false;
+    DiagnosticList sequentialErrors, parallelErrors;
+    auto sequential = parseOnThreads(source, 1, sequentialErrors);
+    auto parallel = parseOnThreads(source, 4, parallelErrors);
+    CHECK_FALSE(hadError);
+    CHECK(parallelErrors.getDiagnostics().empty());
+
+    REQUIRE(parallel.size() == sequential.size());
+    for (std::size_t i = 0; i < parallel.size(); i++) {
+      REQUIRE(parallel[i] != nullptr);
+      CHECK(typeid(*parallel[i]) == typeid(*sequential[i]));
+      if (auto branch = std::dynamic_pointer_cast<If>(parallel[i])) {
+        auto expected = std::dynamic_pointer_cast<If>(sequential[i]);
+        CHECK((branch->getElseBranch() == nullptr) ==
+              (expected->getElseBranch() == nullptr));
+      }
+    }
+  }
+
+  SECTION("The errors are reported in source order") {
+    std::string source;
+    for (int i = 0; i < 300; i++) {
+      source += "print ;\nvar = 1;\n1 = 2;\nprint 1;\n";
+    }
+
+    DiagnosticList sequentialErrors{1000}, parallelErrors{1000};
+    auto sequential = parseOnThreads(source, 1, sequentialErrors);
+    auto parallel = parseOnThreads(source, 4, parallelErrors);
+    hadError = false;
+
+    CHECK(parallel.size() == sequential.size());
+    REQUIRE(parallelErrors.getDiagnostics().size() == 900);
+    for (std::size_t i = 0; i < 900; i++) {
+      const Diagnostic &error = parallelErrors.getDiagnostics()[i];
+      const Diagnostic &expected = sequentialErrors.getDiagnostics()[i];
+      CHECK(error.line == expected.line);
+      CHECK(error.where == expected.where);
+      CHECK(error.message == expected.message);
+    }
+  }
+
+  SECTION("Nesting errors stop all the threads") {
+    std::string source = generateParserSource(100) + "print " +
+                         std::string(5000, '(') + "1" +
+                         std::string(5000, ')') + ";\n" +
+                         "print ;\n" + generateParserSource(100);
+
+    DiagnosticList diagnostics;
+    parseOnThreads(source, 4, diagnostics);
+    hadError = false;
+    REQUIRE(diagnostics.getDiagnostics().size() == 1);
+    CHECK(diagnostics.getDiagnostics()[0].message ==
+          "Expression is nested too deeply.");
+  }
+}
+
+TEST_CASE("Parallel parser throughput in tokens/s",
+          "[.benchmark][parser][threads]") {
+  std::string source = generateParserSource(1000000);
+  Scanner scanner{source};
+  scanner.scanTokens();
+  std::span<const Token> tokens = scanner.getTokens();
+
+  double best = 0;
+  for (int i = 0; i < 3; i++) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::shared_ptr<Stmt>> statements =
+        Parser{tokens}.parse(std::thread::hardware_concurrency());
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    REQUIRE(statements.size() == 1000000);
+    best = std::max(best, tokens.size() / elapsed.count());
+  }
+  WARN("Parsing 1M statements on " << std::thread::hardware_concurrency()
+                                   << " threads: " << best << " tokens/s");
+}
+
+/** Reparses an edited program, checking that it's parsed as if it was parsed
+ * from scratch, and returns how many statements were reused.
+ */
+std::size_t checkReparse(const std::string &program, const std::string &edited,
+                         DiagnosticList &diagnostics) {
+  diagnosticSink = &diagnostics;
+  Scanner original{program};
+  original.scanTokens(1);
+  ParsedProgram previous = Parser{original.getTokens()}.parseProgram();
+
+  Scanner scanner{edited};
+  scanner.scanTokens(1);
+  ParsedProgram reparsed = Parser{scanner.getTokens()}.reparse(previous);
+  ParsedProgram expected = Parser{scanner.getTokens()}.parseProgram();
+  diagnosticSink = nullptr;
+
+  // The serialized programs have the whole AST, with the lines of the tokens
+  CHECK(Serializer{}.serialize(reparsed.statements) ==
+        Serializer{}.serialize(expected.statements));
+  CHECK(reparsed.end == expected.end);
+  REQUIRE(reparsed.spans.size() == expected.spans.size());
+  for (std::size_t i = 0; i < reparsed.spans.size(); i++) {
+    CHECK(reparsed.spans[i].begin == expected.spans[i].begin);
+    CHECK(reparsed.spans[i].end == expected.spans[i].end);
+    CHECK(reparsed.spans[i].hash == expected.spans[i].hash);
+  }
+
+  return std::count_if(
+      reparsed.statements.begin(), reparsed.statements.end(),
+      [&](const std::shared_ptr<Stmt> &stmt) {
+        return stmt && std::find(previous.statements.begin(),
+                         previous.statements.end(),
+                         stmt) != previous.statements.end();
+      });
+}
+
+TEST_CASE("Reparsing edited programs", "[parser][reparse]") {
+  const std::string program = "var a = 1;\n"
+                              "var b = a + 2;\n"
+                              "if (a < b) print a; else print b;\n"
+                              "{ var c = a * b; print c; }\n"
+                              "while (a < 10) a = a + 1;\n"
+                              "for (var i = 0; i < 3; i = i + 1) print i;\n"
+                              "print a == b;\n"
+                              "if (b) print b;\n"
+                              "print \"end\";\n";
+  auto edit = [&](std::string_view from, std::string_view to) {
+    std::string edited = program;
+    std::size_t offset = edited.find(from);
+    REQUIRE(offset != std::string::npos);
+    return edited.replace(offset, from.size(), to);
+  };
+  DiagnosticList diagnostics;
+
+  SECTION("Only the edited statements are parsed") {
+    auto [from, to, reused] =
+        GENERATE(table<std::string, std::string, std::size_t>({
+            {"a + 2", "a + 3", 8},
+            {"print c;", "print c; print a;", 8},
+            {"var a = 1;", "var a = 1; var z = 2;", 9},
+            {"print a == b;", "", 8},
+            {"else print b;", "else { print b; }", 8},
+            {"print \"end\";", "print \"end\"; print 1;", 9},
+            {"2;\nif", "2; if", 2},
+        }));
+
+    hadError = false;
+    CHECK(checkReparse(program, edit(from, to), diagnostics) == reused);
+    CHECK_FALSE(hadError);
+  }
+
+  SECTION("Edits that change how the next statements are parsed") {
+    auto [from, to] = GENERATE(table<std::string, std::string>({
+        {"print c; }", "print c;"},                  // Open a block
+        {"{ var c", "var c"},                        // Close it sooner
+        {"print a; else print b;", "print a;"},      // Drop an else
+        {"print \"end\";", "else print \"end\";"}, // Add an else
+        {"var a = 1;\n", "\nvar a = 1;\n"},         // Move every line
+    }));
+
+    checkReparse(program, edit(from, to), diagnostics);
+    hadError = false;
+  }
+
+  SECTION("Statements with errors are parsed again") {
+    std::string broken = edit("a + 2", "a +");
+    hadError = false;
+    CHECK(checkReparse(program, broken, diagnostics) == 8);
+    CHECK(hadError);
+
+    // Both parses of the edited program report the error
+    REQUIRE(diagnostics.getDiagnostics().size() == 2);
+    CHECK(diagnostics.getDiagnostics()[0].line == 2);
+
+    hadError = false;
+    CHECK(checkReparse(broken, broken, diagnostics) == 8);
+    CHECK(hadError);
+    hadError = false;
+  }
+}
+
+TEST_CASE("Reparsing a large program after an edit",
+          "[.benchmark][parser][reparse]") {
+  std::string program = generateParserSource(1000000);
+  Scanner original{program};
+  original.scanTokens();
+  auto start = std::chrono::steady_clock::now();
+  ParsedProgram previous = Parser{original.getTokens()}.parseProgram();
+  std::chrono::duration<double> parsing =
+      std::chrono::steady_clock::now() - start;
+
+  // Change a number in the middle of the program
+  std::string edited = program;
+  std::size_t offset = edited.find("(1 + 2)", edited.size() / 2) + 1;
+  edited[offset] = '7';
+  start = std::chrono::steady_clock::now();
+  Scanner scanner{edited};
+  scanner.rescan(original.getTokens(), program, {offset, 1, 1});
+  ParsedProgram reparsed = Parser{scanner.getTokens()}.reparse(previous);
+  std::chrono::duration<double> reparsing =
+      std::chrono::steady_clock::now() - start;
+
+  REQUIRE(reparsed.statements.size() == previous.statements.size());
+  WARN("Parsing 1M statements: " << parsing.count()
+                                 << " s, rescanning and reparsing one: "
+                                 << reparsing.count() << " s");
+}
+
+namespace {
+
+std::vector<std::shared_ptr<Stmt>> parseLazily(const Scanner &scanner) {
+  Parser parser{scanner.getTokens()};
+  parser.setLazyBlocks(true);
+  return parser.parse();
+}
+
+} // namespace
+
+TEST_CASE("Parsing blocks lazily", "[parser][lazy]") {
+  DiagnosticList diagnostics;
+  diagnosticSink = &diagnostics;
+  hadError = false;
+
+  SECTION("Blocks keep their tokens until their statements are needed") {
+    const std::string program = "if (debug) { print 1; { print 2; } }\n"
+                                "else print 3;\n";
+    Scanner scanner{program};
+    scanner.scanTokens();
+    std::vector<std::shared_ptr<Stmt>> statements = parseLazily(scanner);
+    REQUIRE(statements.size() == 1);
+    auto ifStmt = std::dynamic_pointer_cast<If>(statements[0]);
+    REQUIRE(ifStmt);
+    auto block = std::dynamic_pointer_cast<Block>(ifStmt->getThenBranch());
+    REQUIRE(block);
+    CHECK(block->isDeferred());
+    CHECK(block->getTokens().size() == 10);
+    CHECK(block->getTokens().front().getType() == TokenType::LEFT_BRACE);
+    CHECK(block->getTokens().back().getType() == TokenType::RIGHT_BRACE);
+    CHECK(std::dynamic_pointer_cast<Print>(ifStmt->getElseBranch()));
+
+    // The inner block is deferred again
+    REQUIRE(block->getStatements().size() == 2);
+    CHECK_FALSE(block->isDeferred());
+    auto inner = std::dynamic_pointer_cast<Block>(block->getStatements()[1]);
+    REQUIRE(inner);
+    CHECK(inner->isDeferred());
+    CHECK(inner->getStatements().size() == 1);
+  }
+
+  SECTION("The statements are the ones parsed eagerly") {
+    const std::string program =
+        "var a = 1;\n"
+        "{ var b = a; { print b; } }\n"
+        "for (var i = 0; i < 3; i = i + 1) { a = a + i; }\n"
+        "while (a > 0) { if (a == 2) { print a; } else { a = a - 1; } }\n";
+    Scanner scanner{program};
+    scanner.scanTokens();
+    std::vector<std::shared_ptr<Stmt>> eager =
+        Parser{scanner.getTokens()}.parse();
+    std::vector<std::shared_ptr<Stmt>> lazy = parseLazily(scanner);
+    // Serializing the statements parses every deferred block
+    CHECK(Serializer{}.serialize(lazy) == Serializer{}.serialize(eager));
+    CHECK_FALSE(hadError);
+  }
+
+  SECTION("Syntax errors are reported when the block is parsed") {
+    const std::string program = "if (false) {\n  print 1 +;\n}\nprint 2;\n";
+    Scanner scanner{program};
+    scanner.scanTokens();
+    std::vector<std::shared_ptr<Stmt>> statements = parseLazily(scanner);
+    REQUIRE(statements.size() == 2);
+    CHECK_FALSE(hadError);
+
+    auto ifStmt = std::dynamic_pointer_cast<If>(statements[0]);
+    REQUIRE(ifStmt);
+    auto block = std::dynamic_pointer_cast<Block>(ifStmt->getThenBranch());
+    REQUIRE(block);
+    CHECK_THROWS_AS(block->getStatements(), RuntimeError);
+    CHECK(hadError);
+    REQUIRE(diagnostics.getDiagnostics().size() == 1);
+    const Diagnostic &error = diagnostics.getDiagnostics()[0];
+    CHECK(error.line == 2);
+    CHECK(error.where == "at ';'");
+    CHECK(error.message == "Expect expression.");
+
+    // The block stays deferred, so it fails again if it runs again
+    CHECK(block->isDeferred());
+    CHECK_THROWS_AS(block->getStatements(), RuntimeError);
+  }
+
+  SECTION("Unbalanced braces are reported right away") {
+    const std::string program = "print 1;\n{ print 2;\n";
+    Scanner scanner{program};
+    scanner.scanTokens();
+    parseLazily(scanner);
+    CHECK(hadError);
+    REQUIRE(diagnostics.getDiagnostics().size() == 1);
+    CHECK(diagnostics.getDiagnostics()[0].message == "Expect '}' after block.");
+  }
+
+  SECTION("Deferred blocks are nested at the depth of the block") {
+    const std::string program = "{ { { { print 1; } } } }";
+    Scanner scanner{program};
+    scanner.scanTokens();
+    Parser parser{scanner.getTokens()};
+    parser.setLazyBlocks(true);
+    parser.setMaxDepth(3);
+    std::vector<std::shared_ptr<Stmt>> statements = parser.parse();
+    CHECK_FALSE(hadError);
+
+    auto descend = [&] {
+      auto block = std::dynamic_pointer_cast<Block>(statements[0]);
+      while (block) {
+        block = std::dynamic_pointer_cast<Block>(block->getStatements()[0]);
+      }
+    };
+    CHECK_THROWS_AS(descend(), RuntimeError);
+    CHECK(hadError);
+    REQUIRE_FALSE(diagnostics.getDiagnostics().empty());
+    CHECK(diagnostics.getDiagnostics()[0].message ==
+          "Statement is nested too deeply.");
+  }
+
+  diagnosticSink = nullptr;
+  hadError = false;
+}
+
+TEST_CASE("Parsing a program with large unused branches",
+          "[.benchmark][parser][lazy]") {
+  std::string program = "var debug = false;\n";
+  for (int branch = 0; branch < 1000; branch++) {
+    program += "if (debug) {\n";
+    for (int i = 0; i < 1000; i++) {
+      program += "  print (1 + 2) * 3 - 4 / 5;\n";
+    }
+    program += "}\n";
+  }
+  Scanner scanner{program};
+  scanner.scanTokens();
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::shared_ptr<Stmt>> eager =
+      Parser{scanner.getTokens()}.parse();
+  std::chrono::duration<double> eagerly =
+      std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  std::vector<std::shared_ptr<Stmt>> lazy = parseLazily(scanner);
+  std::chrono::duration<double> lazily =
+      std::chrono::steady_clock::now() - start;
+
+  REQUIRE(lazy.size() == eager.size());
+  WARN("Parsing 1000 unused branches of 1000 statements: "
+       << eagerly.count() << " s eagerly, " << lazily.count()
+       << " s lazily");
+}
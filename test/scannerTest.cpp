@@ -1,6 +1,7 @@
 #include "gsc/scanner.hpp"
 #include "catch2/catch_amalgamated.hpp"
 #include "gsc/error.hpp"
+#include <chrono>
 #include <iostream>
 #include <sstream>
 
@@ -308,6 +309,26 @@ TEST_CASE("Scanner for identifier token", "[scanner][literals]") {
     checkEOFToken(tokens[1]);
   }
 
+  SECTION("Number too large") {
+    std::ostringstream oss;
+    auto oldCerr = std::cerr.rdbuf(oss.rdbuf());
+
+    hadError = false;
+    Scanner scanner{"1;\n2147483648;"};
+    scanner.scanTokens();
+    std::vector<Token> tokens = scanner.getTokens();
+    std::cerr.rdbuf(oldCerr);
+
+    CHECK(hadError);
+    CHECK(oss.str() == "[line 2] Error : Number literal too large.\n");
+    hadError = false;
+
+    // The token doesn't throw when the Parser reads it
+    checkTokenSize(tokens, 5);
+    CHECK(tokens[2].getType() == TokenType::NUMBER);
+    CHECK_NOTHROW(tokens[2].getLiteral());
+  }
+
   SECTION("Identifier") {
     Scanner scanner{"_myVar123"};
     scanner.scanTokens();
@@ -457,3 +478,240 @@ TEST_CASE("Scanner for multiple combinations", "[scanner][general_program]") {
     checkEOFToken(tokens.back(), 10);
   }
 }
+
+TEST_CASE("Keyword lookup", "[scanner][keywords][hash]") {
+  for (const Keyword &keyword : keywords) {
+    CHECK(keywordType(keyword.text) == keyword.type);
+  }
+
+  // Words with the same length, first and last characters as a keyword
+  for (std::string_view word :
+       {"aid", "od", "iff", "ecee", "tree", "fable", "fur", "whale", "nul",
+        "paint", "vir", "_", "x", "andand", "Var", "PRINT"}) {
+    CHECK(keywordType(word) == TokenType::IDENTIFIER);
+  }
+}
+
+/** Generates a program of about the given size with a mix of every kind of
+ * token. */
+std::string generateScannerSource(std::size_t size) {
+  const std::string_view chunk =
+      "// Sums the numbers and builds a string\n"
+      "var total = 0;\n"
+      "var text = \"start\";\n"
+      "for (var index = 0; index < 100; index = index + 1) {\n"
+      "  if (index >= 50 and total != 1234 or !false) {\n"
+      "    total = total + index * 2 - (index / 3);\n"
+      "  } else {\n"
+      "    text = text + \"more text\";\n"
+      "  }\n"
+      "}\n"
+      "while (total <= 99999) total = total + 1;\n"
+      "print total == nil;\n";
+
+  std::string source;
+  source.reserve(size + chunk.size());
+  while (source.size() < size) {
+    source += chunk;
+  }
+  return source;
+}
+
+TEST_CASE("Scanner throughput", "[.benchmark][scanner]") {
+  std::string source = generateScannerSource(4 * 1024 * 1024);
+
+  BENCHMARK("Scanning 4 MB") {
+    Scanner scanner{source};
+    scanner.scanTokens();
+    return scanner.getTokens().size();
+  };
+}
+
+TEST_CASE("Scanner throughput in MB/s", "[.benchmark][scanner]") {
+  std::string source = generateScannerSource(16 * 1024 * 1024);
+
+  double best = 0;
+  for (int i = 0; i < 5; i++) {
+    auto start = std::chrono::steady_clock::now();
+    Scanner scanner{source};
+    scanner.scanTokens(1);
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best = std::max(best, source.size() / elapsed.count() / 1e6);
+  }
+  WARN("Scanning on a single thread: " << best << " MB/s");
+}
+
+TEST_CASE("Scanner pulling one token at a time", "[scanner][next]") {
+  std::string_view program = "var x = 10; // comment\n"
+                             "while (x > 0) {\n"
+                             "  print \"x is\" + x;\n"
+                             "}\n";
+  Scanner reference{program};
+  reference.scanTokens();
+  const std::vector<Token> &expected = reference.getTokens();
+
+  Scanner scanner{program};
+  for (const Token &token : expected) {
+    Token pulled = scanner.next();
+    CHECK(pulled.toString() == token.toString());
+    CHECK(pulled.getLine() == token.getLine());
+  }
+
+  // The end of the file is returned again if there are more calls
+  checkEOFToken(scanner.next(), 5);
+}
+
+/** Scans a program on a single thread and on several ones (splitting it
+ * every few characters), returning the errors written by each. */
+std::pair<std::string, std::string>
+checkParallelScan(std::string_view program, std::size_t chunkSize) {
+  std::ostringstream sequentialErrors;
+  std::ostringstream parallelErrors;
+  auto oldCerr = std::cerr.rdbuf(sequentialErrors.rdbuf());
+  Scanner sequential{program};
+  sequential.scanTokens(1);
+  std::cerr.rdbuf(parallelErrors.rdbuf());
+  Scanner parallel{program};
+  parallel.scanTokens(4, chunkSize);
+  std::cerr.rdbuf(oldCerr);
+
+  const std::vector<Token> &expected = sequential.getTokens();
+  const std::vector<Token> &tokens = parallel.getTokens();
+  REQUIRE(tokens.size() == expected.size());
+  for (std::size_t i = 0; i < tokens.size(); i++) {
+    CHECK(tokens[i].toString() == expected[i].toString());
+    CHECK(tokens[i].getLine() == expected[i].getLine());
+    // The lexemes are still views into the program
+    CHECK(tokens[i].getLexeme().data() == expected[i].getLexeme().data());
+  }
+  return {sequentialErrors.str(), parallelErrors.str()};
+}
+
+TEST_CASE("Parallel scanning", "[scanner][parallel]") {
+  SECTION("Strings and comments are never split") {
+    std::string program;
+    for (int i = 0; i < 50; i++) {
+      program += "var s = \"a\n// not a comment\nb\";\n"
+                 "// a \" that doesn't start a string\n"
+                 "print s + \"x\"; // trailing\n"
+                 "var n = " +
+                 std::to_string(i) + ";\n";
+    }
+    std::size_t chunkSize = GENERATE(1, 7, 64, 1000);
+
+    auto [sequentialErrors, parallelErrors] =
+        checkParallelScan(program, chunkSize);
+    CHECK(parallelErrors.empty());
+  }
+
+  SECTION("Errors are reported in source order") {
+    std::string program;
+    for (int i = 0; i < 40; i++) {
+      program += "var a = 1; @\nprint a # 2;\n";
+    }
+    program += "print \"unterminated\n\n";
+
+    hadError = false;
+    auto [sequentialErrors, parallelErrors] = checkParallelScan(program, 16);
+    CHECK(hadError);
+    CHECK(parallelErrors == sequentialErrors);
+    hadError = false;
+  }
+
+  SECTION("Small programs are scanned on a single thread") {
+    auto [sequentialErrors, parallelErrors] =
+        checkParallelScan("print 1;\nprint 2;\n", Scanner::minChunkSize);
+    CHECK(parallelErrors.empty());
+  }
+}
+
+TEST_CASE("Parallel scanner throughput", "[.benchmark][scanner][parallel]") {
+  std::string source = generateScannerSource(32 * 1024 * 1024);
+
+  BENCHMARK("Scanning 32 MB on a single thread") {
+    Scanner scanner{source};
+    scanner.scanTokens(1);
+    return scanner.getTokens().size();
+  };
+
+  BENCHMARK("Scanning 32 MB on all the threads") {
+    Scanner scanner{source};
+    scanner.scanTokens();
+    return scanner.getTokens().size();
+  };
+}
+
+/** Applies an edit to a program, rescans it and checks the tokens against
+ * scanning the edited program from scratch. Returns the scanned tokens. */
+std::size_t checkRescan(std::string_view program, std::size_t offset,
+                        std::size_t removed, std::string_view text) {
+  Scanner original{program};
+  original.scanTokens(1);
+
+  std::string edited{program};
+  edited.replace(offset, removed, text);
+  Scanner reference{edited};
+  reference.scanTokens(1);
+  Scanner scanner{edited};
+  std::size_t scanned = scanner.rescan(original.getTokens(), program,
+                                       {offset, removed, text.size()});
+
+  const std::vector<Token> &expected = reference.getTokens();
+  const std::vector<Token> &tokens = scanner.getTokens();
+  REQUIRE(tokens.size() == expected.size());
+  for (std::size_t i = 0; i < tokens.size(); i++) {
+    CHECK(tokens[i].toString() == expected[i].toString());
+    CHECK(tokens[i].getLine() == expected[i].getLine());
+    CHECK(tokens[i].getLexeme().data() == expected[i].getLexeme().data());
+  }
+  return scanned;
+}
+
+TEST_CASE("Rescanning edited programs", "[scanner][rescan]") {
+  std::string_view program = "var total = 10; // a comment\n"
+                             "var text = \"two\nlines\";\n"
+                             "while (total >= 0) total = total - 1;\n"
+                             "print text + \"!\";\n";
+
+  SECTION("Edits that only change a few tokens") {
+    auto [offset, removed, text] =
+        GENERATE(table<std::size_t, std::size_t, std::string>({
+            {4, 5, "count"},            // Rename a variable
+            {12, 2, "12345"},           // Change a number
+            {0, 0, "print 1;\n"},       // Insert a line at the start
+            {0, 29, ""},                // Remove the first line
+            {29, 0, "\n\n"},            // Add new lines
+            {19, 0, "//"},              // Comment the end of a line
+            {3, 1, ""},                 // Merge two tokens
+            {109, 0, "x;"},             // Insert at the end
+            {66, 2, "<"},               // Change an operator
+        }));
+
+    std::size_t scanned = checkRescan(program, offset, removed, text);
+    CHECK(scanned <= 4);
+  }
+
+  SECTION("Edits that change the rest of the program") {
+    auto [offset, removed, text] =
+        GENERATE(table<std::size_t, std::size_t, std::string>({
+            {16, 0, "\""},   // Open a string
+            {40, 1, ""},     // Remove an opening quote
+            {15, 0, "@ #"},  // Unexpected characters
+        }));
+
+    std::ostringstream oss;
+    auto oldCerr = std::cerr.rdbuf(oss.rdbuf());
+    checkRescan(program, offset, removed, text);
+    std::cerr.rdbuf(oldCerr);
+    hadError = false;
+  }
+
+  SECTION("A one-line edit in a large program") {
+    std::string source = generateScannerSource(1024 * 1024);
+    std::size_t offset = source.find("total = 0;", source.size() / 2);
+    REQUIRE(offset != std::string::npos);
+
+    CHECK(checkRescan(source, offset, 5, "count") <= 2);
+  }
+}
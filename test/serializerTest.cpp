@@ -0,0 +1,217 @@
+#include "gsc/serializer.hpp"
+#include "catch2/catch_amalgamated.hpp"
+#include "gsc/error.hpp"
+#include "gsc/liveness.hpp"
+#include "gsc/sourceMap.hpp"
+#include "gsc/typeInference.hpp"
+#include "testHelpers.hpp"
+
+namespace {
+
+const std::string serializedProgram = R"(
+var a = 1;
+var text = "a" + "b";
+print text;
+{
+  var a = a * 2 - -3;
+  print a;
+}
+if (a == 1 and !false) print "one"; else print nil;
+if (a != 1 or true) print (a + 2) / 3;
+for (var i = 0; i < 3; i = i + 1) print i;
+while (a < 4) a = a + 1;
+print a >= 4;
+)";
+
+/** Returns where the names of the declarations of the program are. */
+std::vector<std::pair<int, int>>
+declarationLocations(const std::vector<std::shared_ptr<Stmt>> &statements,
+                     std::string_view source) {
+  SourceMap map{source};
+  std::vector<std::pair<int, int>> locations;
+  for (const std::shared_ptr<Stmt> &stmt : statements) {
+    if (auto declaration = std::dynamic_pointer_cast<Var>(stmt)) {
+      std::optional<SourceLocation> location =
+          map.locate(declaration->getName().getLexeme());
+      REQUIRE(location);
+      locations.emplace_back(location->line, location->column);
+    }
+  }
+  return locations;
+}
+
+/** Writes `print 1 <op> 2;` by hand, with the given type of the operator. */
+std::string serializedBinary(TokenType op) {
+  std::string data{SERIALIZED_MAGIC};
+  data += std::string{"\x02\x00\x00\x00", 4}; // Version
+  data += "\x01";                                // Statements
+  data += "\x01\x01+";                           // String table
+  data += std::string{"\x00", 1};               // No locations
+  data += "\x03\x07";                            // Print of a binary
+  data += "\x0a\x03\x02";                        // Literal 1
+  data += static_cast<char>(op);
+  data += std::string{"\x02\x00", 2}; // On line 1, with the lexeme "+"
+  data += "\x0a\x03\x04";             // Literal 2
+  return data;
+}
+
+} // namespace
+
+TEST_CASE("Serializing parsed programs", "[serializer]") {
+  hadError = false;
+  std::vector<std::shared_ptr<Stmt>> statements = parse(serializedProgram);
+  REQUIRE_FALSE(hadError);
+  std::string data = Serializer{}.serialize(statements);
+
+  SECTION("The loaded program runs like the parsed one") {
+    CHECK(isSerialized(data));
+    std::vector<std::shared_ptr<Stmt>> loaded = deserialize(data);
+    REQUIRE(loaded.size() == statements.size());
+    CHECK(interpretCapturing(loaded) == interpretCapturing(statements));
+  }
+
+  SECTION("Serializing a loaded program gives the same bytes") {
+    CHECK(Serializer{}.serialize(deserialize(data)) == data);
+  }
+
+  SECTION("The tokens are views into the serialized data") {
+    std::vector<std::shared_ptr<Stmt>> loaded = deserialize(data);
+    std::shared_ptr<Var> declaration =
+        std::dynamic_pointer_cast<Var>(loaded[0]);
+    REQUIRE(declaration != nullptr);
+    std::string_view name = declaration->getName().getLexeme();
+    CHECK(name == "a");
+    CHECK(name.data() >= data.data());
+    CHECK(name.data() < data.data() + data.size());
+    CHECK(declaration->getName().getLine() == 2);
+  }
+
+  SECTION("Names are stored once") {
+    // The tokens are views into the source, which must outlive them
+    const std::string line =
+        "variableWithALongName = variableWithALongName + 1;\n";
+    std::string repeated;
+    for (int i = 0; i < 100; i++) {
+      repeated += line;
+    }
+    std::string once = Serializer{}.serialize(parse(line));
+    std::string many = Serializer{}.serialize(parse(repeated));
+    CHECK(many.find("variableWithALongName") ==
+          many.rfind("variableWithALongName"));
+    CHECK(many.size() < 100 * once.size());
+  }
+
+  SECTION("Invalid data is rejected") {
+    CHECK_FALSE(isSerialized(serializedProgram));
+    CHECK_THROWS_AS(deserialize(serializedProgram), FormatError);
+    CHECK_THROWS_AS(deserialize(data.substr(0, data.size() - 1)),
+                    FormatError);
+    CHECK_THROWS_AS(deserialize(data + "x"), FormatError);
+
+    std::string otherVersion = data;
+    otherVersion[SERIALIZED_MAGIC.size()]++;
+    CHECK_THROWS_AS(deserialize(otherVersion), FormatError);
+
+    // Truncating the data anywhere is detected instead of crashing
+    for (std::size_t size = 0; size < data.size(); size++) {
+      CHECK_THROWS_AS(deserialize(data.substr(0, size)), FormatError);
+    }
+  }
+}
+
+TEST_CASE("Serializing programs with their locations", "[serializer]") {
+  const std::string source = "var a = 1;\n  var  bb = a;\n\n var c = \"x\";";
+  hadError = false;
+  std::vector<std::shared_ptr<Stmt>> statements = parse(source);
+  REQUIRE_FALSE(hadError);
+  std::string data = Serializer{}.serialize(statements, source);
+  std::vector<std::pair<int, int>> expected = {{1, 5}, {2, 8}, {4, 6}};
+  REQUIRE(declarationLocations(statements, source) == expected);
+
+  SECTION("Loading with the source gives views into it") {
+    std::vector<std::shared_ptr<Stmt>> loaded = deserialize(data, source);
+    CHECK(declarationLocations(loaded, source) == expected);
+    CHECK(interpretCapturing(loaded) == interpretCapturing(statements));
+  }
+
+  SECTION("Loading without the source rebuilds its lines and columns") {
+    std::string restored;
+    std::vector<std::shared_ptr<Stmt>> loaded =
+        deserializeRestoring(data, restored);
+    CHECK(restored.size() == source.size());
+    CHECK(declarationLocations(loaded, restored) == expected);
+    CHECK(Serializer{}.serialize(loaded, restored) == data);
+  }
+
+  SECTION("The locations are optional") {
+    CHECK(interpretCapturing(deserialize(data)) ==
+          interpretCapturing(statements));
+
+    std::string restored = "old";
+    std::string withoutLocations = Serializer{}.serialize(statements);
+    CHECK(withoutLocations.size() < data.size());
+    CHECK(deserializeRestoring(withoutLocations, restored).size() == 3);
+    CHECK(restored.empty());
+    CHECK_THROWS_AS(deserialize(withoutLocations, source), FormatError);
+  }
+
+  SECTION("Another source is rejected") {
+    std::string other = source;
+    other[4] = 'z';
+    CHECK_THROWS_AS(deserialize(data, other), FormatError);
+    CHECK_THROWS_AS(deserialize(data, source + " "), FormatError);
+    CHECK_THROWS_AS(Serializer{}.serialize(statements, other), FormatError);
+  }
+}
+
+TEST_CASE("Reading corrupted programs", "[serializer]") {
+  SECTION("A hand-written program is read") {
+    std::vector<std::shared_ptr<Stmt>> loaded =
+        deserialize(serializedBinary(PLUS));
+    CHECK(interpretCapturing(loaded) == "3\n");
+  }
+
+  SECTION("Operators of another node are rejected") {
+    CHECK_THROWS_AS(deserialize(serializedBinary(AND)), FormatError);
+    CHECK_THROWS_AS(deserialize(serializedBinary(IDENTIFIER)), FormatError);
+    CHECK_THROWS_AS(deserialize(serializedBinary(BANG)), FormatError);
+  }
+
+  SECTION("Missing children are rejected") {
+    // A print without its expression
+    std::string data{SERIALIZED_MAGIC};
+    data += std::string{"\x02\x00\x00\x00\x01\x00\x00\x03\x00", 9};
+    CHECK_THROWS_AS(deserialize(data), FormatError);
+
+    // A binary without its right operand
+    data = serializedBinary(PLUS);
+    data.replace(data.size() - 3, 3, 1, '\x00');
+    CHECK_THROWS_AS(deserialize(data), FormatError);
+
+    // A missing statement of the program
+    data = serializedBinary(PLUS);
+    data.replace(data.size() - 11, 11, 1, '\x00');
+    CHECK_THROWS_AS(deserialize(data), FormatError);
+  }
+
+  SECTION("Changing any byte gives a complete tree or a FormatError") {
+    std::string source = serializedProgram;
+    std::string data = Serializer{}.serialize(parse(source), source);
+    for (std::size_t i = 0; i < data.size(); i++) {
+      for (char value : {'\x00', '\x01', '\x03', '\x7f', '\xff'}) {
+        std::string corrupted = data;
+        corrupted[i] = value;
+        try {
+          // The passes visit every required child, so they'd crash on a
+          // missing one
+          std::string restored;
+          std::vector<std::shared_ptr<Stmt>> loaded =
+              deserializeRestoring(corrupted, restored);
+          TypeInference().analyze(loaded);
+          Liveness().analyze(loaded);
+        } catch (const FormatError &) {
+        }
+      }
+    }
+  }
+}
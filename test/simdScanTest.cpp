@@ -0,0 +1,98 @@
+#include "gsc/simdScan.hpp"
+#include "catch2/catch_amalgamated.hpp"
+#include "gsc/scanner.hpp"
+#include <string>
+
+/** Builds a text of the given length where the run checked by a test is
+ * interrupted by `stop` at the position `stopAt`. */
+std::string simdRunText(std::string_view run, char stop, std::size_t length,
+                        std::size_t stopAt) {
+  std::string text;
+  for (std::size_t i = 0; i < length; i++) {
+    text += run[i % run.size()];
+  }
+  if (stopAt < length) {
+    text[stopAt] = stop;
+  }
+  return text;
+}
+
+TEST_CASE("SIMD levels", "[simd][levels]") {
+  SimdLevel level = detectSimdLevel();
+
+  CHECK(detectSimdLevel() == level);
+  CHECK(&scanFunctions(SimdLevel::SCALAR) != &scanFunctions(level));
+#if !defined(__x86_64__)
+  CHECK(level == SimdLevel::SCALAR);
+#endif
+}
+
+TEST_CASE("SIMD runs match the scalar ones", "[simd][runs]") {
+  SimdLevel level = GENERATE(SimdLevel::SSE2, SimdLevel::AVX2);
+  const ScanFunctions &scalar = scanFunctions(SimdLevel::SCALAR);
+  const ScanFunctions &simd = scanFunctions(level);
+
+  // Lengths and stop positions around the 16 and 32 byte boundaries
+  for (std::size_t length = 0; length <= 70; length++) {
+    for (std::size_t stopAt = 0; stopAt <= length; stopAt++) {
+      CAPTURE(length, stopAt);
+
+      std::string whitespace = simdRunText(" \t\n\r\n", 'x', length, stopAt);
+      const char *begin = whitespace.data();
+      const char *end = begin + whitespace.size();
+      int scalarLines = 0;
+      int simdLines = 0;
+      REQUIRE(simd.skipWhitespace(begin, end, simdLines) ==
+              scalar.skipWhitespace(begin, end, scalarLines));
+      REQUIRE(simdLines == scalarLines);
+
+      for (char stop : {' ', '(', '`', '{', '@', '[', '/', ':', '\xC3'}) {
+        std::string identifier =
+            simdRunText("aZ_09zA", stop, length, stopAt);
+        begin = identifier.data();
+        end = begin + identifier.size();
+        REQUIRE(simd.skipIdentifier(begin, end) ==
+                scalar.skipIdentifier(begin, end));
+      }
+
+      std::string body = simdRunText("ab\nc ", '"', length, stopAt);
+      begin = body.data();
+      end = begin + body.size();
+      scalarLines = 0;
+      simdLines = 0;
+      REQUIRE(simd.findStringEnd(begin, end, simdLines) ==
+              scalar.findStringEnd(begin, end, scalarLines));
+      REQUIRE(simdLines == scalarLines);
+
+      std::string comment = simdRunText("comment \"", '\n', length, stopAt);
+      begin = comment.data();
+      end = begin + comment.size();
+      REQUIRE(simd.findLineEnd(begin, end) == scalar.findLineEnd(begin, end));
+    }
+  }
+}
+
+TEST_CASE("Scanning with every SIMD level", "[simd][scanner]") {
+  std::string program =
+      "// A comment that is long enough to take more than one chunk\n"
+      "var aVeryLongIdentifierName_with_digits_0123456789 = \"a string\n"
+      "that spans a few lines and is longer than thirty two bytes\";\n"
+      "                                                            \n"
+      "\t\t\r\n  if (a and b) print aVeryLongIdentifierName_with_digits_0;\n";
+
+  Scanner reference{program, SimdLevel::SCALAR};
+  reference.scanTokens();
+  std::vector<Token> expected = reference.getTokens();
+
+  for (SimdLevel level : {SimdLevel::SSE2, SimdLevel::AVX2}) {
+    Scanner scanner{program, level};
+    scanner.scanTokens();
+    std::vector<Token> tokens = scanner.getTokens();
+
+    REQUIRE(tokens.size() == expected.size());
+    for (std::size_t i = 0; i < tokens.size(); i++) {
+      CHECK(tokens[i].toString() == expected[i].toString());
+      CHECK(tokens[i].getLine() == expected[i].getLine());
+    }
+  }
+}
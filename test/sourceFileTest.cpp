@@ -0,0 +1,56 @@
+#include "gsc/sourceFile.hpp"
+#include "catch2/catch_amalgamated.hpp"
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <unistd.h>
+
+/** Writes a temporary source file and returns its path. */
+std::string writeSourceFile(std::string_view name, std::string_view content) {
+  std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+  std::ofstream file{path, std::ios::binary};
+  file << content;
+  return path.string();
+}
+
+TEST_CASE("Loading source files", "[sourceFile]") {
+  SECTION("Regular files are mapped") {
+    std::string content = "var a = 1;\nprint a;\n";
+    std::string path = writeSourceFile("gscSourceFileTest.sc", content);
+    {
+      SourceFile source{path};
+      CHECK(source.isMapped());
+      CHECK(source.getContent() == content);
+    }
+    std::filesystem::remove(path);
+  }
+
+  SECTION("Empty files") {
+    std::string path = writeSourceFile("gscEmptySourceFileTest.sc", "");
+    {
+      SourceFile source{path};
+      CHECK(source.getContent().empty());
+    }
+    std::filesystem::remove(path);
+  }
+
+  SECTION("Missing files") {
+    CHECK_THROWS_AS(SourceFile{"gscMissingSourceFile.sc"}, std::system_error);
+  }
+
+  SECTION("Pipes are read into a buffer") {
+    std::string content = "print \"from a pipe\";\n";
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    REQUIRE(write(fds[1], content.data(), content.size()) ==
+            static_cast<ssize_t>(content.size()));
+    close(fds[1]);
+
+    {
+      SourceFile source{"/dev/fd/" + std::to_string(fds[0])};
+      CHECK_FALSE(source.isMapped());
+      CHECK(source.getContent() == content);
+    }
+    close(fds[0]);
+  }
+}
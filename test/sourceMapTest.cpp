@@ -0,0 +1,74 @@
+#include "gsc/sourceMap.hpp"
+#include "catch2/catch_amalgamated.hpp"
+#include "gsc/error.hpp"
+#include "gsc/interpreter.hpp"
+#include "gsc/parser.hpp"
+#include "gsc/scanner.hpp"
+#include <iostream>
+#include <sstream>
+#include <string>
+
+TEST_CASE("Locating tokens in the source", "[sourceMap]") {
+  const std::string source = "var a = 1;\n\n  print a / 0;\nprint a";
+  SourceMap map{source};
+
+  SECTION("Offsets are lines and columns") {
+    CHECK(map.getLineCount() == 4);
+    SourceLocation start = map.locate(0);
+    CHECK(start.line == 1);
+    CHECK(start.column == 1);
+    SourceLocation empty = map.locate(source.find("\n\n") + 1);
+    CHECK(empty.line == 2);
+    CHECK(empty.column == 1);
+    SourceLocation slash = map.locate(source.find('/'));
+    CHECK(slash.line == 3);
+    CHECK(slash.column == 11);
+    SourceLocation end = map.locate(source.size());
+    CHECK(end.line == 4);
+    CHECK(end.column == 8);
+  }
+
+  SECTION("Lexemes are located by where they point to") {
+    std::string_view view = source;
+    std::optional<SourceLocation> location =
+        map.locate(view.substr(source.rfind('a'), 1));
+    REQUIRE(location);
+    CHECK(location->line == 4);
+    CHECK(location->column == 7);
+
+    std::string copy = source;
+    CHECK_FALSE(map.contains(std::string_view{copy}.substr(0, 3)));
+    CHECK_FALSE(map.locate(std::string_view{copy}.substr(0, 3)));
+    CHECK(map.contains(view.substr(source.size())));
+  }
+
+  SECTION("Lines are read without their new line") {
+    CHECK(map.getLine(1) == "var a = 1;");
+    CHECK(map.getLine(2).empty());
+    CHECK(map.getLine(3) == "  print a / 0;");
+    CHECK(map.getLine(4) == "print a");
+    CHECK(map.getLine(5).empty());
+  }
+
+  SECTION("Runtime errors give the column of their token") {
+    // The last line isn't a statement
+    std::string_view program = source;
+    Scanner scanner{program.substr(0, source.rfind('\n') + 1)};
+    std::vector<std::shared_ptr<Stmt>> statements = Parser{scanner}.parse();
+
+    std::ostringstream out;
+    std::ostringstream err;
+    auto oldCout = std::cout.rdbuf(out.rdbuf());
+    auto oldCerr = std::cerr.rdbuf(err.rdbuf());
+    sourceMap = &map;
+    hadRuntimeError = false;
+    Interpreter().interpret(statements);
+    sourceMap = nullptr;
+    std::cout.rdbuf(oldCout);
+    std::cerr.rdbuf(oldCerr);
+
+    CHECK(hadRuntimeError);
+    hadRuntimeError = false;
+    CHECK(err.str() == "Division by zero.\n[line 3, column 11]\n");
+  }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "gsc/interpreter.hpp"
+#include "gsc/parser.hpp"
+#include "gsc/scanner.hpp"
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/** @brief Scans and parses a program.
+ *
+ * @note The tokens are views into `program`, so it must outlive the returned
+ * statements.
+ */
+inline std::vector<std::shared_ptr<Stmt>> parse(std::string_view program) {
+  Scanner scanner{program};
+  scanner.scanTokens();
+  Parser parser{scanner.getTokens()};
+  return parser.parse();
+}
+
+/** @brief Interprets the statements and returns what they printed. */
+inline std::string
+interpretCapturing(const std::vector<std::shared_ptr<Stmt>> &statements) {
+  std::ostringstream oss;
+  auto oldCout = std::cout.rdbuf(oss.rdbuf());
+  Interpreter().interpret(statements);
+  std::cout.rdbuf(oldCout);
+  return oss.str();
+}
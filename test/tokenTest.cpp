@@ -71,3 +71,35 @@ TEST_CASE("Token toString method", "[token][toString]") {
     CHECK(token.toString() == "AND && nil");
   }
 }
+
+TEST_CASE("Token literal decoded from the lexeme", "[token][literal]") {
+  SECTION("NUMBER type") {
+    Token token(TokenType::NUMBER, "1234", 1);
+    REQUIRE(token.getLiteral().type() == typeid(int));
+    CHECK(std::any_cast<int>(token.getLiteral()) == 1234);
+  }
+
+  SECTION("NUMBER type out of range") {
+    Token token(TokenType::NUMBER, "99999999999", 1);
+    CHECK_THROWS_AS(token.getLiteral(), std::out_of_range);
+  }
+
+  SECTION("STRING type") {
+    Token token(TokenType::STRING, "\"hello\"", 1);
+    REQUIRE(token.getLiteral().type() == typeid(std::string));
+    CHECK(std::any_cast<std::string>(token.getLiteral()) == "hello");
+    CHECK(token.toString() == "STRING \"hello\" hello");
+  }
+
+  SECTION("Other types") {
+    Token token(TokenType::IDENTIFIER, "name", 1);
+    CHECK(token.getLiteral().type() == typeid(std::nullptr_t));
+  }
+
+  SECTION("The lexeme is a view of the source") {
+    std::string_view source = "var x;";
+    Token token(TokenType::IDENTIFIER, source.substr(4, 1), 1);
+    CHECK(token.getLexeme().data() == source.data() + 4);
+    CHECK(sizeof(Token) <= 40);
+  }
+}
@@ -0,0 +1,171 @@
+#include "gsc/typeInference.hpp"
+#include "catch2/catch_amalgamated.hpp"
+#include "gsc/error.hpp"
+#include "gsc/interpreter.hpp"
+#include "testHelpers.hpp"
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+std::shared_ptr<Binary> printedBinary(const std::shared_ptr<Stmt> &stmt) {
+  std::shared_ptr<Print> print = std::dynamic_pointer_cast<Print>(stmt);
+  REQUIRE(print != nullptr);
+  std::shared_ptr<Binary> binary =
+      std::dynamic_pointer_cast<Binary>(print->getExpression());
+  REQUIRE(binary != nullptr);
+  return binary;
+}
+
+} // namespace
+
+TEST_CASE("Type inference of variables", "[typeInference][dump]") {
+  TypeInference inference;
+  std::ostringstream dump;
+
+  SECTION("Monomorphic program") {
+    inference.analyze(parse("var a = 1;\n"
+                            "var s = \"hi\";\n"
+                            "var b = a < 2;\n"
+                            "var n;\n"
+                            "a = a * 3;"));
+    inference.dump(dump);
+
+    CHECK(inference.isMonomorphic());
+    CHECK(dump.str() == "a (line 1): int\n"
+                        "s (line 2): string\n"
+                        "b (line 3): bool\n"
+                        "n (line 4): nil\n"
+                        "monomorphic: yes\n");
+  }
+
+  SECTION("Variable reassigned with another type") {
+    inference.analyze(parse("var x = 1;\nx = \"one\";"));
+    inference.dump(dump);
+
+    CHECK_FALSE(inference.isMonomorphic());
+    CHECK(dump.str() == "x (line 1): any\nmonomorphic: no\n");
+  }
+
+  SECTION("Shadowed variables are different declarations") {
+    inference.analyze(parse("var x = 1;\n{\n  var x = \"a\";\n}"));
+    inference.dump(dump);
+
+    CHECK(inference.isMonomorphic());
+    CHECK(dump.str() == "x (line 1): int\n"
+                        "x (line 3): string\n"
+                        "monomorphic: yes\n");
+  }
+
+  SECTION("Declarations inside loops are reported once") {
+    inference.analyze(
+        parse("for (var i = 0; i < 3; i = i + 1) { var t = i; }"));
+    inference.dump(dump);
+
+    CHECK(dump.str() == "i (line 1): int\n"
+                        "t (line 1): int\n"
+                        "monomorphic: yes\n");
+  }
+}
+
+TEST_CASE("Type inference of binary operands", "[typeInference][binary]") {
+  TypeInference inference;
+
+  SECTION("Numbers") {
+    std::vector<std::shared_ptr<Stmt>> statements =
+        parse("var a = 1; var b = 2; print a + b;");
+    inference.analyze(statements);
+    CHECK(printedBinary(statements[2])->getOperandType() == OperandType::INT);
+  }
+
+  SECTION("Strings") {
+    std::vector<std::shared_ptr<Stmt>> statements =
+        parse("var a = \"x\"; print a + \"y\";");
+    inference.analyze(statements);
+    CHECK(printedBinary(statements[1])->getOperandType() ==
+          OperandType::STRING);
+  }
+
+  SECTION("Mixed operands") {
+    std::vector<std::shared_ptr<Stmt>> statements =
+        parse("var a = \"x\"; print a + 1;");
+    inference.analyze(statements);
+    CHECK(printedBinary(statements[1])->getOperandType() ==
+          OperandType::UNKNOWN);
+  }
+
+  SECTION("Undeclared variables") {
+    std::vector<std::shared_ptr<Stmt>> statements = parse("print a + 1;");
+    inference.analyze(statements);
+    CHECK(printedBinary(statements[0])->getOperandType() ==
+          OperandType::UNKNOWN);
+  }
+
+  SECTION("Join of if branches") {
+    std::vector<std::shared_ptr<Stmt>> statements =
+        parse("var a = 1; if (a) a = 2; else a = \"two\"; print a + 1;"
+              "var b = 1; if (b) b = 2; print b + 1;");
+    inference.analyze(statements);
+    CHECK(printedBinary(statements[2])->getOperandType() ==
+          OperandType::UNKNOWN);
+    CHECK(printedBinary(statements[5])->getOperandType() == OperandType::INT);
+  }
+
+  SECTION("Type changed later in a loop") {
+    std::vector<std::shared_ptr<Stmt>> statements =
+        parse("var a = 1; while (a) { print a + 1; a = \"\"; }");
+    inference.analyze(statements);
+
+    std::shared_ptr<While> loop =
+        std::dynamic_pointer_cast<While>(statements[1]);
+    REQUIRE(loop != nullptr);
+    std::shared_ptr<Block> body =
+        std::dynamic_pointer_cast<Block>(loop->getBody());
+    REQUIRE(body != nullptr);
+    CHECK(printedBinary(body->getStatements()[0])->getOperandType() ==
+          OperandType::UNKNOWN);
+  }
+}
+
+TEST_CASE("Interpreting annotated programs", "[typeInference][interpreter]") {
+  // Hide the error output
+  std::ostringstream errorStream;
+  auto oldCerr = std::cerr.rdbuf(errorStream.rdbuf());
+
+  // Redirect output to a string stream
+  std::ostringstream outputStream;
+  auto oldCout = std::cout.rdbuf(outputStream.rdbuf());
+
+  TypeInference inference;
+
+  SECTION("Same results with proven types") {
+    std::vector<std::shared_ptr<Stmt>> statements =
+        parse("var a = 7; var b = 2; var s = \"a\";"
+              "print a + b; print a - b; print a * b; print a / b;"
+              "print a < b; print a <= b; print a > b; print a >= b;"
+              "print a == b; print a != b;"
+              "print s + s; print s == s; print s != s;");
+    inference.analyze(statements);
+    Interpreter().interpret(statements);
+
+    CHECK(outputStream.str() == "9\n5\n14\n3\n"
+                                "false\nfalse\ntrue\ntrue\n"
+                                "false\ntrue\n"
+                                "aa\ntrue\nfalse\n");
+  }
+
+  SECTION("Division by zero is still reported") {
+    hadRuntimeError = false;
+    std::vector<std::shared_ptr<Stmt>> statements =
+        parse("var a = 1; var b = 0; print a / b;");
+    inference.analyze(statements);
+    Interpreter().interpret(statements);
+
+    CHECK(hadRuntimeError);
+    CHECK(outputStream.str() == "");
+  }
+
+  // Restore the original buffers
+  std::cout.rdbuf(oldCout);
+  std::cerr.rdbuf(oldCerr);
+}